@@ -31,31 +31,84 @@
 #ifdef __cplusplus
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 
 extern "C" {
 #else // __cplusplus
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 #endif // __cplusplus
 
 
+#define FONT2C_FLAG_MONOSPACE           0x00000001u     // glyphs share metrics and are located via range table
+#define FONT2C_FLAG_MSB_FIRST           0x00000002u     // pixels are packed most-significant bits first
+#define FONT2C_FLAG_EXTERNAL            0x00000004u     // pixel data is held outside the font and fetched via callback
+#define FONT2C_FLAG_BITSTREAM           0x00000008u     // pixels form one bitstream, glyph offsets are in bits
+#define FONT2C_FLAG_TILED               0x00000010u     // pixels form a tile set, glyph offsets index tile map
+#define FONT2C_FLAG_COLOR               0x00000020u     // pixels are pre-blended colours in font's format
+#define FONT2C_FLAG_PLANAR              0x00000040u     // glyphs are stored as 1bpp bit-planes, lsb plane first
+
+#ifndef FONT2C_ROW_CHUNK
+#define FONT2C_ROW_CHUNK                64              // number of pixels decoded per step when blitting
+#endif
+
+
 typedef enum {
     FONT2C_COMPRESSION_NONE
 } font2c_compression_t;
 
 
+typedef enum {
+    FONT2C_RASTER_LRTB,                 // left-to-right, top-to-bottom
+    FONT2C_RASTER_RLTB,                 // right-to-left, top-to-bottom
+    FONT2C_RASTER_LRBT,                 // left-to-right, bottom-to-top
+    FONT2C_RASTER_RLBT,                 // right-to-left, bottom-to-top
+    FONT2C_RASTER_TBLR,                 // top-to-bottom, left-to-right
+    FONT2C_RASTER_TBRL,                 // top-to-bottom, right-to-left
+    FONT2C_RASTER_BTLR,                 // bottom-to-top, left-to-right
+    FONT2C_RASTER_BTRL,                 // bottom-to-top, right-to-left
+    FONT2C_RASTER_PAGE                  // pages of vertical bytes (8 / depth pixels each), left-to-right, top-to-bottom
+} font2c_raster_t;
+
+
+typedef enum {
+    FONT2C_FORMAT_MONO,                 // 1bpp, most-significant bit is leftmost pixel
+    FONT2C_FORMAT_GRAY8,                // 8bpp grayscale
+    FONT2C_FORMAT_RGB565,               // 16bpp, native-endian uint16_t per pixel
+    FONT2C_FORMAT_RGB888,               // 24bpp, bytes in R, G, B order
+    FONT2C_FORMAT_ARGB8888              // 32bpp, native-endian uint32_t per pixel, alpha in most-significant byte
+} font2c_format_t;
+
+
 typedef struct {
     uint32_t codepoint;                 // glyph's unicode codepoint
-    uint32_t offset;                    // offset of first bitmap byte in pixel table
+    uint32_t offset;                    // offset of first bitmap byte in pixel table (bit offset for bitstream fonts)
     int16_t x_bearing;                  // horizontal offset of glyph bitmap's top-left corner relative to its origin
     int16_t y_bearing;                  // vertical offset of glyph's bitmap's top-left corner relative to its origin
     uint16_t width;                     // width of glyph's bitmap
     uint16_t height;                    // height of glyph's bitmap
     int16_t x_advance;                  // distance to advance cursor horizontally after rendering glyph
+    uint8_t depth;                      // bits per pixel of glyph's bitmap if it differs from font's (0 = font's)
 } font2c_glyph_t;
 
 
 typedef struct {
+    uint32_t first;                     // first codepoint in range
+    uint32_t count;                     // number of consecutive codepoints in range
+    uint32_t index;                     // glyph index of first codepoint in range
+} font2c_range_t;
+
+
+typedef struct {
+    uint16_t left;                      // glyph index of left-hand glyph
+    uint16_t right;                     // glyph index of right-hand glyph
+    int16_t x_adjust;                   // adjustment to left-hand glyph's advance when followed by right-hand glyph
+} font2c_kerning_t;
+
+
+typedef struct font2c_font_s {
     const uint8_t* pixels;              // pointer to font's bitmap data
     const font2c_glyph_t* glyphs;       // pointer to font's glyph lookup table
     uint32_t n_glyphs;                  // number of glyphs in lookup table
@@ -64,11 +117,287 @@ typedef struct {
     int16_t center;                     // font's vertical center line
     int16_t line_height;                // minimum distance that should be left between lines
     font2c_compression_t compression;   // pixel data compression scheme
+    uint32_t flags;                     // font flags (FONT2C_FLAG_*)
+    const font2c_range_t* ranges;       // pointer to codepoint range table (monospace fonts only)
+    uint32_t n_ranges;                  // number of ranges in range table
+    uint32_t glyph_size;                // size of every glyph's bitmap, in bits if bitstream (monospace fonts only)
+    font2c_glyph_t mono_glyph;          // metrics shared by all glyphs (monospace fonts only)
+    const font2c_kerning_t* kerning;    // pointer to kerning pair table, sorted by left then right glyph index
+    uint32_t n_kerning;                 // number of pairs in kerning pair table
+    uint8_t depth;                      // bits per pixel of glyph bitmaps
+    font2c_raster_t raster;             // order in which pixels of glyph bitmaps are stored
+    const uint8_t* hot_pixels;          // pointer to bitmap data of frequently used glyphs, stored ahead of pixels
+    uint32_t hot_size;                  // size of hot bitmap data in bytes, offsets below this refer to hot_pixels
+    uint8_t row_align;                  // each bitmap line is padded to a multiple of this many bytes (0 = 1)
+    const uint16_t* tile_map;           // pointer to tile indices of every glyph, row by row (tiled fonts only)
+    uint8_t tile_width;                 // width of each tile in pixels (tiled fonts only)
+    uint8_t tile_height;                // height of each tile in pixels (tiled fonts only)
+    uint32_t tile_size;                 // distance between tiles in tile set in bytes (tiled fonts only)
+    font2c_format_t format;             // surface format of pre-blended pixels (colour fonts only)
+    const uint8_t* levels;              // coverage of each pixel value at font's depth (NULL = evenly spaced)
+    const struct font2c_font_s* fallback; // font searched for codepoints missing from this one (e.g. base shard)
 } font2c_font_t;
 
 
+typedef struct {
+    const font2c_font_t* font;          // font being iterated over
+    const uint8_t* text;                // next byte of UTF-8 text to decode
+    const uint8_t* end;                 // end of UTF-8 text
+    uint32_t codepoint;                 // codepoint of current glyph
+    int32_t index;                      // glyph index of current glyph (-1 before first glyph of a line)
+    font2c_glyph_t glyph;               // current glyph
+    int32_t x;                          // horizontal position of current glyph's origin relative to start of line
+    int32_t y;                          // vertical position of current glyph's origin relative to first baseline
+    int32_t next_x;                     // horizontal position of cursor after current glyph, before kerning
+    uint32_t line;                      // line number of current glyph
+    const font2c_font_t* glyph_font;    // font holding current glyph, font itself or one of its fallbacks
+} font2c_iter_t;
+
+
+typedef struct {
+    int32_t width;                      // advance width of widest line
+    int32_t ink_x1;                     // left edge of inked area relative to origin of first line
+    int32_t ink_y1;                     // top edge of inked area relative to origin of first line
+    int32_t ink_x2;                     // right edge (exclusive) of inked area relative to origin of first line
+    int32_t ink_y2;                     // bottom edge (exclusive) of inked area relative to origin of first line
+    uint32_t n_lines;                   // number of lines in text (a final line break ends the last line)
+} font2c_metrics_t;
+
+
+typedef struct {
+    uint32_t start;                     // byte offset of line's first character within text
+    uint32_t length;                    // length of line in bytes, excluding trailing spaces and line break
+    int32_t width;                      // advance width of line, excluding trailing spaces
+} font2c_line_t;
+
+
+typedef struct {
+    uint8_t* pixels;                    // pointer to first pixel of framebuffer
+    uint32_t pitch;                     // distance between framebuffer rows in bytes
+    int16_t width;                      // width of framebuffer in pixels
+    int16_t height;                     // height of framebuffer in pixels
+    font2c_format_t format;             // framebuffer pixel format
+    int16_t clip_x1;                    // left edge of clip region
+    int16_t clip_y1;                    // top edge of clip region
+    int16_t clip_x2;                    // right edge (exclusive) of clip region
+    int16_t clip_y2;                    // bottom edge (exclusive) of clip region
+} font2c_surface_t;
+
+
+typedef struct {
+    const uint8_t* data;                // glyph's pixel data
+    uint32_t stride;                    // distance between raster lines in bytes (0 if lines are not contiguous)
+    uint32_t bit_offset;                // bit position of first pixel within data (bitstream fonts only)
+    uint32_t line_bits;                 // distance between raster lines in bits
+    uint16_t width;                     // width of glyph's bitmap
+    uint16_t height;                    // height of glyph's bitmap
+    uint8_t depth;                      // bits per pixel
+    bool msb_first;                     // pixels packed most-significant bits first
+    font2c_raster_t raster;             // order in which pixels are stored
+    const uint16_t* tiles;              // glyph's tile indices, row by row (NULL unless font is tiled)
+    uint16_t tile_cols;                 // number of tiles across glyph
+    uint8_t tile_width;                 // width of each tile in pixels
+    uint8_t tile_height;                // height of each tile in pixels
+    uint32_t tile_size;                 // distance between tiles in bytes
+    uint32_t plane_size;                // distance between bit-planes in bytes (0 unless font is planar)
+    const uint8_t* levels;              // coverage of each pixel value (NULL = evenly spaced)
+} font2c_bitmap_t;
+
+
+typedef struct {
+    font2c_bitmap_t bitmap;             // glyph's bitmap
+    int32_t x;                          // left edge of glyph's bitmap on scanline
+    int32_t y;                          // top row of glyph's bitmap
+    const uint8_t* line;                // next raster line of glyph's bitmap to be decoded
+} font2c_span_t;
+
+
+typedef struct {
+    font2c_span_t* spans;               // caller-supplied span array, one entry per inked glyph
+    size_t n_spans;                     // number of spans in use
+    int32_t y;                          // next scanline to be rendered
+    int32_t y_end;                      // bottom edge (exclusive) of text's inked area
+} font2c_scanline_t;
+
+
+typedef struct {
+    int32_t x;                          // left edge of rectangle
+    int32_t y;                          // top edge of rectangle
+    int32_t width;                      // width of rectangle
+    int32_t height;                     // height of rectangle
+} font2c_rect_t;
+
+
+typedef struct {
+    uint32_t codepoint;                 // codepoint of glyph occupying cell
+    int32_t x;                          // horizontal position of glyph's origin relative to label's origin
+    int32_t x1;                         // left edge of cell (union of advance and ink) relative to label's origin
+    int32_t x2;                         // right edge (exclusive) of cell relative to label's origin
+} font2c_cell_t;
+
+
+typedef struct {
+    const font2c_font_t* font;          // font used to render label
+    font2c_cell_t* cells;               // caller-supplied cell array holding label's current layout
+    size_t max_cells;                   // number of entries in cell array
+    size_t n_cells;                     // number of cells in use
+    int32_t x;                          // horizontal position of label's origin
+    int32_t y;                          // vertical position of label's baseline
+} font2c_label_t;
+
+
+typedef struct {
+    uint32_t codepoint;                 // codepoint of cached glyph
+    uint8_t* coverage;                  // decoded 8-bit coverage of glyph, width * height bytes in lrtb order
+    bool valid;                         // entry holds a decoded glyph
+    bool referenced;                    // entry used since CLOCK hand last passed it
+} font2c_cache_entry_t;
+
+
+typedef struct {
+    const font2c_font_t* font;          // font whose glyphs are cached
+    font2c_cache_entry_t* entries;      // caller-supplied entry array
+    uint32_t n_entries;                 // number of entries in entry array
+    uint32_t slot_size;                 // size of each entry's coverage buffer in bytes
+    uint32_t hand;                      // index of next entry considered for eviction
+    uint32_t hits;                      // number of lookups satisfied from cache
+    uint32_t misses;                    // number of lookups that required glyph to be decoded
+} font2c_cache_t;
+
+
+typedef bool (*font2c_read_t)(void* context, uint32_t offset, void* buffer, uint32_t length);
+
+
+typedef struct {
+    font2c_glyph_t glyph;               // glyph metrics, offset becomes relative to run's pixel buffer once fetched
+    int32_t x;                          // horizontal position of glyph's origin relative to run's origin
+    int32_t y;                          // vertical position of glyph's origin relative to run's origin
+} font2c_run_glyph_t;
+
+
+typedef struct {
+    font2c_font_t font;                 // copy of source font, pixels point at run's pixel buffer once fetched
+    font2c_run_glyph_t* glyphs;         // caller-supplied glyph array
+    size_t n_glyphs;                    // number of glyphs in run
+    int32_t width;                      // advance width of run's widest line
+    uint32_t size;                      // number of pixel buffer bytes filled by fetch
+    uint32_t n_reads;                   // number of read transactions issued by fetch
+} font2c_run_t;
+
+
 static inline const font2c_glyph_t* font2c_find_glyph(const font2c_font_t* font, uint32_t codepoint);
 
+static inline int32_t font2c_find_index(const font2c_font_t* font, uint32_t codepoint);
+
+static inline void font2c_glyph_at(const font2c_font_t* font, uint32_t index, font2c_glyph_t* glyph);
+
+static inline bool font2c_get_glyph(const font2c_font_t* font, uint32_t codepoint, font2c_glyph_t* glyph);
+
+static inline const font2c_font_t* font2c_find_font(const font2c_font_t* font, uint32_t codepoint,
+                                                    font2c_glyph_t* glyph);
+
+static inline const uint8_t* font2c_glyph_pixels(const font2c_font_t* font, const font2c_glyph_t* glyph);
+
+static inline uint8_t font2c_glyph_depth(const font2c_font_t* font, const font2c_glyph_t* glyph);
+
+static inline uint32_t font2c_glyph_stride(const font2c_font_t* font, const font2c_glyph_t* glyph);
+
+static inline uint32_t font2c_glyph_size(const font2c_font_t* font, const font2c_glyph_t* glyph);
+
+static inline uint32_t font2c_plane_size(const font2c_font_t* font, const font2c_glyph_t* glyph);
+
+static inline const uint8_t* font2c_glyph_plane(const font2c_font_t* font, const font2c_glyph_t* glyph,
+                                                uint8_t plane);
+
+static inline const uint16_t* font2c_glyph_tiles(const font2c_font_t* font, const font2c_glyph_t* glyph,
+                                                 uint32_t* cols, uint32_t* rows);
+
+static inline const uint8_t* font2c_tile_pixels(const font2c_font_t* font, uint16_t tile);
+
+static inline void font2c_place_tiles(uint16_t* table, int32_t table_width, int32_t table_height,
+                                      const font2c_font_t* font, const font2c_glyph_t* glyph, int32_t col, int32_t row);
+
+static inline int16_t font2c_kerning(const font2c_font_t* font, int32_t left_index, int32_t right_index);
+
+static inline int32_t font2c_text_width(const font2c_font_t* font, const uint32_t* codepoints, size_t n_codepoints);
+
+static inline int32_t font2c_find_index_near(const font2c_font_t* font, uint32_t codepoint, int32_t hint);
+
+static inline uint32_t font2c_decode_utf8(const uint8_t** text, const uint8_t* end);
+
+static inline void font2c_iter_init(font2c_iter_t* iter, const font2c_font_t* font, const char* text, size_t length);
+
+static inline bool font2c_iter_next(font2c_iter_t* iter);
+
+static inline void font2c_measure_utf8(const font2c_font_t* font, const char* text, size_t length,
+                                       font2c_metrics_t* metrics);
+
+static inline size_t font2c_wrap_utf8(const font2c_font_t* font, const char* text, size_t length, int32_t max_width,
+                                      font2c_line_t* lines, size_t max_lines);
+
+static inline void font2c_bitmap_init(font2c_bitmap_t* bitmap, const font2c_font_t* font, const font2c_glyph_t* glyph);
+
+static inline uint32_t font2c_bits_get(const uint8_t* data, uint32_t bit, uint8_t depth, bool msb_first);
+
+static inline uint8_t font2c_bitmap_get(const font2c_bitmap_t* bitmap, int32_t x, int32_t y);
+
+static inline void font2c_bitmap_row(const font2c_bitmap_t* bitmap, int32_t x, int32_t y, int32_t n, uint8_t* coverage);
+
+static inline void font2c_surface_init(font2c_surface_t* surface, void* pixels, font2c_format_t format,
+                                       int16_t width, int16_t height, uint32_t pitch);
+
+static inline void font2c_page_blit(uint8_t* pages, int32_t width, int32_t n_pages, const font2c_font_t* font,
+                                    const font2c_glyph_t* glyph, int32_t x, int32_t y);
+
+static inline void font2c_surface_set_clip(font2c_surface_t* surface, int16_t x, int16_t y, int16_t width,
+                                           int16_t height);
+
+static inline void font2c_blit_coverage(font2c_surface_t* surface, int32_t x, int32_t y, int32_t width, int32_t height,
+                                        const uint8_t* coverage, uint32_t coverage_pitch, uint32_t color);
+
+static inline void font2c_blit_glyph(font2c_surface_t* surface, const font2c_font_t* font,
+                                     const font2c_glyph_t* glyph, int32_t x, int32_t y, uint32_t color);
+
+static inline int32_t font2c_draw_utf8(font2c_surface_t* surface, const font2c_font_t* font, int32_t x, int32_t y,
+                                       const char* text, size_t length, uint32_t color);
+
+static inline bool font2c_scanline_init(font2c_scanline_t* scanline, const font2c_font_t* font, int32_t x, int32_t y,
+                                        const char* text, size_t length, font2c_span_t* spans, size_t max_spans);
+
+static inline bool font2c_scanline_render(font2c_scanline_t* scanline, uint8_t* coverage, int32_t width);
+
+static inline void font2c_fill_rect(font2c_surface_t* surface, int32_t x, int32_t y, int32_t width, int32_t height,
+                                    uint32_t color);
+
+static inline void font2c_label_init(font2c_label_t* label, const font2c_font_t* font, int32_t x, int32_t y,
+                                     font2c_cell_t* cells, size_t max_cells);
+
+static inline size_t font2c_label_update(font2c_label_t* label, const char* text, size_t length,
+                                         font2c_rect_t* dirty, size_t max_dirty);
+
+static inline void font2c_label_draw(const font2c_label_t* label, font2c_surface_t* surface,
+                                     const font2c_rect_t* dirty, size_t n_dirty, uint32_t color, uint32_t background);
+
+static inline void font2c_cache_init(font2c_cache_t* cache, const font2c_font_t* font, font2c_cache_entry_t* entries,
+                                     uint32_t n_entries, uint8_t* pool, uint32_t slot_size);
+
+static inline const uint8_t* font2c_cache_get(font2c_cache_t* cache, const font2c_glyph_t* glyph);
+
+static inline void font2c_blit_cached(font2c_surface_t* surface, font2c_cache_t* cache,
+                                      const font2c_glyph_t* glyph, int32_t x, int32_t y, uint32_t color);
+
+static inline int32_t font2c_draw_utf8_cached(font2c_surface_t* surface, font2c_cache_t* cache, int32_t x, int32_t y,
+                                              const char* text, size_t length, uint32_t color);
+
+static inline size_t font2c_run_init(font2c_run_t* run, const font2c_font_t* font, const char* text, size_t length,
+                                     font2c_run_glyph_t* glyphs, size_t max_glyphs);
+
+static inline bool font2c_run_fetch(font2c_run_t* run, font2c_read_t read, void* context, uint8_t* buffer,
+                                    uint32_t buffer_size, uint32_t max_gap);
+
+static inline void font2c_run_draw(font2c_surface_t* surface, const font2c_run_t* run, int32_t x, int32_t y,
+                                   uint32_t color);
+
 
 #ifndef _DOXYGEN
 
@@ -77,6 +406,10 @@ static inline const font2c_glyph_t* font2c_find_glyph(const font2c_font_t* font,
     int32_t l = 0;
     int32_t r = (int32_t) (font->n_glyphs - 1);
 
+    if ( !glyphs ) {
+        return NULL;
+    }
+
     while (l <= r) {
         int32_t m = (l + r) / 2;
         uint32_t glyph_codepoint = glyphs[m].codepoint;
@@ -97,6 +430,1742 @@ static inline const font2c_glyph_t* font2c_find_glyph(const font2c_font_t* font,
     return NULL;
 }
 
+
+static inline const font2c_range_t* font2c_find_range(const font2c_font_t* font, uint32_t codepoint) {
+    const font2c_range_t* ranges = font->ranges;
+    int32_t l = 0;
+    int32_t r = (int32_t) font->n_ranges - 1;
+
+    while (l <= r) {
+        int32_t m = (l + r) / 2;
+
+        if ( codepoint < ranges[m].first ) {
+            r = m - 1;
+        } else if ( (codepoint - ranges[m].first) >= ranges[m].count ) {
+            l = m + 1;
+        } else {
+            return &ranges[m];
+        }
+    }
+
+    return NULL;
+}
+
+
+static inline int32_t font2c_find_index(const font2c_font_t* font, uint32_t codepoint) {
+    if ( font->flags & FONT2C_FLAG_MONOSPACE ) {
+        const font2c_range_t* range = font2c_find_range(font, codepoint);
+
+        return range ? (int32_t) (range->index + (codepoint - range->first)) : -1;
+    } else {
+        const font2c_glyph_t* glyph = font2c_find_glyph(font, codepoint);
+
+        return glyph ? (int32_t) (glyph - font->glyphs) : -1;
+    }
+}
+
+
+static inline void font2c_glyph_of(const font2c_font_t* font, uint32_t index, uint32_t codepoint,
+                                   font2c_glyph_t* glyph) {
+    // callers that looked the codepoint up already know it, so a monospace glyph needs no range search
+    if ( font->flags & FONT2C_FLAG_MONOSPACE ) {
+        *glyph = font->mono_glyph;
+        glyph->codepoint = codepoint;
+        glyph->offset = index * font->glyph_size;
+    } else {
+        *glyph = font->glyphs[index];
+    }
+}
+
+
+static inline void font2c_glyph_at(const font2c_font_t* font, uint32_t index, font2c_glyph_t* glyph) {
+    if ( font->flags & FONT2C_FLAG_MONOSPACE ) {
+        const font2c_range_t* ranges = font->ranges;
+        int32_t l = 0;
+        int32_t r = (int32_t) font->n_ranges - 1;
+
+        // ranges are in index order as well as codepoint order
+        while (l < r) {
+            int32_t m = (l + r + 1) / 2;
+
+            if ( ranges[m].index <= index ) {
+                l = m;
+            } else {
+                r = m - 1;
+            }
+        }
+
+        font2c_glyph_of(font, index, ranges[l].first + (index - ranges[l].index), glyph);
+    } else {
+        *glyph = font->glyphs[index];
+    }
+}
+
+
+static inline bool font2c_get_glyph(const font2c_font_t* font, uint32_t codepoint, font2c_glyph_t* glyph) {
+    int32_t index = font2c_find_index(font, codepoint);
+
+    if ( index < 0 ) {
+        return false;
+    }
+
+    font2c_glyph_of(font, (uint32_t) index, codepoint, glyph);
+
+    return true;
+}
+
+
+static inline const uint8_t* font2c_glyph_pixels(const font2c_font_t* font, const font2c_glyph_t* glyph) {
+    if ( font->flags & FONT2C_FLAG_BITSTREAM ) {
+        return font->pixels + (glyph->offset >> 3);
+    }
+
+    if ( glyph->offset < font->hot_size ) {
+        return font->hot_pixels + glyph->offset;
+    }
+
+    return font->pixels + (glyph->offset - font->hot_size);
+}
+
+
+static inline uint8_t font2c_glyph_depth(const font2c_font_t* font, const font2c_glyph_t* glyph) {
+    return glyph->depth ? glyph->depth : font->depth;
+}
+
+
+static inline uint8_t font2c_plane_depth(const font2c_font_t* font, const font2c_glyph_t* glyph) {
+    return (font->flags & FONT2C_FLAG_PLANAR) ? 1 : font2c_glyph_depth(font, glyph);
+}
+
+
+static inline uint32_t font2c_line_length(const font2c_font_t* font, const font2c_glyph_t* glyph) {
+    switch(font->raster) {
+    case FONT2C_RASTER_TBLR:
+    case FONT2C_RASTER_TBRL:
+    case FONT2C_RASTER_BTLR:
+    case FONT2C_RASTER_BTRL: return glyph->height;
+    case FONT2C_RASTER_PAGE: return (uint32_t) glyph->width * (8 / font2c_plane_depth(font, glyph));
+    default:                 return glyph->width;
+    }
+}
+
+
+static inline uint32_t font2c_line_count(const font2c_font_t* font, const font2c_glyph_t* glyph) {
+    switch(font->raster) {
+    case FONT2C_RASTER_TBLR:
+    case FONT2C_RASTER_TBRL:
+    case FONT2C_RASTER_BTLR:
+    case FONT2C_RASTER_BTRL: return glyph->width;
+    case FONT2C_RASTER_PAGE: return glyph->height / (8 / font2c_plane_depth(font, glyph));
+    default:                 return glyph->height;
+    }
+}
+
+
+static inline uint32_t font2c_glyph_stride(const font2c_font_t* font, const font2c_glyph_t* glyph) {
+    uint32_t stride = ((font2c_line_length(font, glyph) * font2c_plane_depth(font, glyph)) + 7) / 8;
+
+    if ( font->row_align > 1 ) {
+        stride = (stride + font->row_align - 1) & ~(uint32_t) (font->row_align - 1);
+    }
+
+    return stride;
+}
+
+
+static inline uint32_t font2c_glyph_size(const font2c_font_t* font, const font2c_glyph_t* glyph) {
+    if ( font->flags & FONT2C_FLAG_BITSTREAM ) {
+        uint32_t bits = (uint32_t) glyph->width * glyph->height * font2c_glyph_depth(font, glyph);
+
+        return ((glyph->offset & 7) + bits + 7) / 8;
+    }
+
+    if ( font->flags & FONT2C_FLAG_TILED ) {
+        return ((uint32_t) glyph->width / font->tile_width) * (glyph->height / font->tile_height) * sizeof(uint16_t);
+    }
+
+    if ( font->flags & FONT2C_FLAG_PLANAR ) {
+        return font2c_plane_size(font, glyph) * font2c_glyph_depth(font, glyph);
+    }
+
+    return font2c_plane_size(font, glyph);
+}
+
+
+static inline uint32_t font2c_plane_size(const font2c_font_t* font, const font2c_glyph_t* glyph) {
+    return font2c_glyph_stride(font, glyph) * font2c_line_count(font, glyph);
+}
+
+
+static inline const uint8_t* font2c_glyph_plane(const font2c_font_t* font, const font2c_glyph_t* glyph,
+                                                uint8_t plane) {
+    if ( !(font->flags & FONT2C_FLAG_PLANAR) || (font->flags & FONT2C_FLAG_TILED) ||
+         plane >= font2c_glyph_depth(font, glyph) ) {
+        return NULL;
+    }
+
+    return font2c_glyph_pixels(font, glyph) + (plane * font2c_plane_size(font, glyph));
+}
+
+
+static inline const uint16_t* font2c_glyph_tiles(const font2c_font_t* font, const font2c_glyph_t* glyph,
+                                                 uint32_t* cols, uint32_t* rows) {
+    if ( !(font->flags & FONT2C_FLAG_TILED) ) {
+        return NULL;
+    }
+
+    *cols = glyph->width / font->tile_width;
+    *rows = glyph->height / font->tile_height;
+
+    return font->tile_map + glyph->offset;
+}
+
+
+static inline const uint8_t* font2c_tile_pixels(const font2c_font_t* font, uint16_t tile) {
+    return font->pixels + ((uint32_t) tile * font->tile_size);
+}
+
+
+static inline void font2c_place_tiles(uint16_t* table, int32_t table_width, int32_t table_height,
+                                      const font2c_font_t* font, const font2c_glyph_t* glyph,
+                                      int32_t col, int32_t row) {
+    const uint16_t* tiles;
+    uint32_t cols;
+    uint32_t rows;
+    uint32_t tx;
+    uint32_t ty;
+
+    tiles = font2c_glyph_tiles(font, glyph, &cols, &rows);
+
+    if ( !tiles ) {
+        return;
+    }
+
+    // bitmaps are aligned to tile grid, so bearings are whole numbers of tiles
+    col += glyph->x_bearing / font->tile_width;
+    row -= glyph->y_bearing / font->tile_height;
+
+    for (ty = 0; ty < rows; ty++) {
+        int32_t r = row + (int32_t) ty;
+
+        if ( r < 0 || r >= table_height ) {
+            continue;
+        }
+
+        for (tx = 0; tx < cols; tx++) {
+            int32_t c = col + (int32_t) tx;
+
+            if ( c >= 0 && c < table_width ) {
+                table[(r * table_width) + c] = tiles[(ty * cols) + tx];
+            }
+        }
+    }
+}
+
+
+static inline int16_t font2c_kerning(const font2c_font_t* font, int32_t left_index, int32_t right_index) {
+    const font2c_kerning_t* pairs = font->kerning;
+    uint32_t key;
+    int32_t l = 0;
+    int32_t r = (int32_t) font->n_kerning - 1;
+
+    if ( left_index < 0 || right_index < 0 ) {
+        return 0;
+    }
+
+    key = ((uint32_t) left_index << 16) | (uint32_t) right_index;
+
+    while (l <= r) {
+        int32_t m = (l + r) / 2;
+        uint32_t pair_key = ((uint32_t) pairs[m].left << 16) | pairs[m].right;
+
+        if ( pair_key < key ) {
+            l = m + 1;
+        } else if ( pair_key > key ) {
+            r = m - 1;
+        } else {
+            return pairs[m].x_adjust;
+        }
+    }
+
+    return 0;
+}
+
+
+static inline int32_t font2c_find_index_chain(const font2c_font_t** font, uint32_t codepoint, int32_t hint) {
+    const font2c_font_t* shard = *font;
+    int32_t index = font2c_find_index_near(shard, codepoint, hint);
+
+    // codepoints missing from a locale shard are looked up in its base shard, and so on down the chain
+    while ( index < 0 && shard->fallback ) {
+        shard = shard->fallback;
+        index = font2c_find_index(shard, codepoint);
+    }
+
+    *font = shard;
+
+    return index;
+}
+
+
+static inline const font2c_font_t* font2c_find_font(const font2c_font_t* font, uint32_t codepoint,
+                                                    font2c_glyph_t* glyph) {
+    int32_t index = font2c_find_index_chain(&font, codepoint, -1);
+
+    if ( index < 0 ) {
+        return NULL;
+    }
+
+    font2c_glyph_of(font, (uint32_t) index, codepoint, glyph);
+
+    return font;
+}
+
+
+static inline int32_t font2c_text_width(const font2c_font_t* font, const uint32_t* codepoints, size_t n_codepoints) {
+    int32_t width = 0;
+    int32_t prev_index = -1;
+
+    const font2c_font_t* prev_font = font;
+
+    for (size_t i = 0; i < n_codepoints; i++) {
+        const font2c_font_t* shard = font;
+        font2c_glyph_t glyph;
+        int32_t index = font2c_find_index_chain(&shard, codepoints[i], -1);
+
+        if ( index < 0 ) {
+            continue;
+        }
+
+        font2c_glyph_of(shard, (uint32_t) index, codepoints[i], &glyph);
+        width += ((shard == prev_font) ? font2c_kerning(shard, prev_index, index) : 0) + glyph.x_advance;
+        prev_index = index;
+        prev_font = shard;
+    }
+
+    return width;
+}
+
+
+static inline int32_t font2c_search_glyphs(const font2c_glyph_t* glyphs, int32_t l, int32_t r, uint32_t codepoint) {
+    while (l <= r) {
+        int32_t m = (l + r) / 2;
+        uint32_t glyph_codepoint = glyphs[m].codepoint;
+
+        if ( glyph_codepoint < codepoint ) {
+            l = m + 1;
+        } else if ( glyph_codepoint > codepoint ) {
+            r = m - 1;
+        } else {
+            return m;
+        }
+    }
+
+    return -1;
+}
+
+
+static inline int32_t font2c_find_index_near(const font2c_font_t* font, uint32_t codepoint, int32_t hint) {
+    const font2c_glyph_t* glyphs = font->glyphs;
+    int32_t n = (int32_t) font->n_glyphs;
+    int32_t step = 1;
+    int32_t l;
+    int32_t r;
+
+    if ( (font->flags & FONT2C_FLAG_MONOSPACE) || hint < 0 || hint >= n ) {
+        return font2c_find_index(font, codepoint);
+    }
+
+    // gallop outwards from hint, so nearby codepoints cost O(log distance) rather than O(log n_glyphs)
+    if ( glyphs[hint].codepoint == codepoint ) {
+        return hint;
+    } else if ( glyphs[hint].codepoint < codepoint ) {
+        l = hint + 1;
+        r = hint + 1;
+
+        while ( r < n && glyphs[r].codepoint < codepoint ) {
+            l = r + 1;
+            step <<= 1;
+            r = hint + step;
+        }
+
+        if ( r >= n ) {
+            r = n - 1;
+        }
+    } else {
+        l = hint - 1;
+        r = hint - 1;
+
+        while ( l >= 0 && glyphs[l].codepoint > codepoint ) {
+            r = l - 1;
+            step <<= 1;
+            l = hint - step;
+        }
+
+        if ( l < 0 ) {
+            l = 0;
+        }
+    }
+
+    return font2c_search_glyphs(glyphs, l, r, codepoint);
+}
+
+
+static inline uint32_t font2c_decode_utf8(const uint8_t** text, const uint8_t* end) {
+    const uint8_t* p = *text;
+    uint32_t c = *p++;
+    uint32_t min;
+    int n;
+
+    if ( c < 0x80 ) {
+        *text = p;
+        return c;
+    } else if ( (c & 0xE0) == 0xC0 ) {
+        c &= 0x1F;
+        min = 0x80;
+        n = 1;
+    } else if ( (c & 0xF0) == 0xE0 ) {
+        c &= 0x0F;
+        min = 0x800;
+        n = 2;
+    } else if ( (c & 0xF8) == 0xF0 ) {
+        c &= 0x07;
+        min = 0x10000;
+        n = 3;
+    } else {
+        *text = p;
+        return 0xFFFD;
+    }
+
+    while (n--) {
+        if ( p == end || (*p & 0xC0) != 0x80 ) {
+            *text = p;
+            return 0xFFFD;
+        }
+
+        c = (c << 6) | (*p++ & 0x3F);
+    }
+
+    *text = p;
+
+    if ( c < min || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF) ) {
+        return 0xFFFD;
+    }
+
+    return c;
+}
+
+
+static inline void font2c_iter_init(font2c_iter_t* iter, const font2c_font_t* font, const char* text, size_t length) {
+    iter->font = font;
+    iter->text = (const uint8_t*) text;
+    iter->end = iter->text + length;
+    iter->codepoint = 0;
+    iter->index = -1;
+    iter->x = 0;
+    iter->y = 0;
+    iter->next_x = 0;
+    iter->line = 0;
+    iter->glyph_font = font;
+}
+
+
+static inline bool font2c_iter_next(font2c_iter_t* iter) {
+    const font2c_font_t* font = iter->font;
+    int32_t hint = (iter->glyph_font == font) ? iter->index : -1;
+
+    while (iter->text < iter->end) {
+        uint32_t codepoint = font2c_decode_utf8(&iter->text, iter->end);
+        const font2c_font_t* shard = font;
+        int32_t index;
+
+        if ( codepoint == '\n' ) {
+            iter->index = -1;
+            iter->next_x = 0;
+            iter->y += font->line_height;
+            iter->line++;
+            continue;
+        }
+
+        index = font2c_find_index_chain(&shard, codepoint, hint);
+
+        if ( index < 0 ) {
+            continue;
+        }
+
+        if ( index != iter->index || iter->index < 0 || shard != iter->glyph_font ) {
+            font2c_glyph_of(shard, (uint32_t) index, codepoint, &iter->glyph);
+        }
+
+        // kerning pairs only exist between glyphs of the same shard
+        iter->x = iter->next_x + ((shard == iter->glyph_font) ? font2c_kerning(shard, iter->index, index) : 0);
+        iter->next_x = iter->x + iter->glyph.x_advance;
+        iter->codepoint = codepoint;
+        iter->index = index;
+        iter->glyph_font = shard;
+
+        return true;
+    }
+
+    return false;
+}
+
+
+static inline void font2c_measure_utf8(const font2c_font_t* font, const char* text, size_t length,
+                                       font2c_metrics_t* metrics) {
+    font2c_iter_t iter;
+    bool inked = false;
+
+    metrics->width = 0;
+    metrics->ink_x1 = 0;
+    metrics->ink_y1 = 0;
+    metrics->ink_x2 = 0;
+    metrics->ink_y2 = 0;
+
+    font2c_iter_init(&iter, font, text, length);
+
+    while ( font2c_iter_next(&iter) ) {
+        const font2c_glyph_t* glyph = &iter.glyph;
+
+        if ( iter.next_x > metrics->width ) {
+            metrics->width = iter.next_x;
+        }
+
+        if ( glyph->width && glyph->height ) {
+            int32_t x1 = iter.x + glyph->x_bearing;
+            int32_t y1 = iter.y - glyph->y_bearing;
+            int32_t x2 = x1 + glyph->width;
+            int32_t y2 = y1 + glyph->height;
+
+            if ( !inked ) {
+                metrics->ink_x1 = x1;
+                metrics->ink_y1 = y1;
+                metrics->ink_x2 = x2;
+                metrics->ink_y2 = y2;
+                inked = true;
+            } else {
+                if ( x1 < metrics->ink_x1 ) metrics->ink_x1 = x1;
+                if ( y1 < metrics->ink_y1 ) metrics->ink_y1 = y1;
+                if ( x2 > metrics->ink_x2 ) metrics->ink_x2 = x2;
+                if ( y2 > metrics->ink_y2 ) metrics->ink_y2 = y2;
+            }
+        }
+    }
+
+    // a final line break ends the last line rather than starting an empty one, as in font2c_wrap_utf8()
+    metrics->n_lines = (length && text[length - 1] != '\n') ? (iter.line + 1) : iter.line;
+}
+
+
+static inline void font2c_emit_line(font2c_line_t* lines, size_t max_lines, size_t* n_lines,
+                                    uint32_t start, uint32_t end, int32_t width) {
+    if ( *n_lines < max_lines ) {
+        lines[*n_lines].start = start;
+        lines[*n_lines].length = end - start;
+        lines[*n_lines].width = width;
+    }
+
+    (*n_lines)++;
+}
+
+
+static inline size_t font2c_wrap_utf8(const font2c_font_t* font, const char* text, size_t length, int32_t max_width,
+                                      font2c_line_t* lines, size_t max_lines) {
+    const uint8_t* begin = (const uint8_t*) text;
+    const uint8_t* p = begin;
+    const uint8_t* end = begin + length;
+    size_t n_lines = 0;
+    uint32_t line_start = 0;
+    int32_t x = 0;
+    int32_t prev_index = -1;
+    const font2c_font_t* prev_font = font;
+    int32_t hint = -1;
+    bool in_space = false;
+    bool has_break = false;
+    uint32_t break_end = 0;             // where line ends if broken at last space run
+    int32_t break_width = 0;            // width of line if broken at last space run
+    uint32_t resume = 0;                // where next line starts if broken at last space run
+    int32_t resume_x = 0;               // position of first glyph after last space run
+
+    if ( !length ) {
+        return 0;
+    }
+
+    while (p < end) {
+        uint32_t pos = (uint32_t) (p - begin);
+        uint32_t codepoint = font2c_decode_utf8(&p, end);
+        const font2c_font_t* shard = font;
+        font2c_glyph_t glyph;
+        int32_t index;
+        int32_t kerning;
+
+        if ( codepoint == '\n' ) {
+            if ( in_space ) {
+                font2c_emit_line(lines, max_lines, &n_lines, line_start, break_end, break_width);
+            } else {
+                font2c_emit_line(lines, max_lines, &n_lines, line_start, pos, x);
+            }
+
+            line_start = (uint32_t) (p - begin);
+            x = 0;
+            prev_index = -1;
+            in_space = false;
+            has_break = false;
+            continue;
+        }
+
+        index = font2c_find_index_chain(&shard, codepoint, (prev_font == font) ? hint : -1);
+
+        if ( index < 0 ) {
+            continue;
+        }
+
+        hint = index;
+        font2c_glyph_of(shard, (uint32_t) index, codepoint, &glyph);
+        kerning = (shard == prev_font) ? font2c_kerning(shard, prev_index, index) : 0;
+
+        if ( codepoint == ' ' ) {
+            if ( !in_space ) {
+                break_end = pos;
+                break_width = x;
+                has_break = true;
+                in_space = true;
+            }
+
+            x += kerning + glyph.x_advance;
+        } else {
+            if ( in_space ) {
+                resume = pos;
+                resume_x = x + kerning;
+                in_space = false;
+            }
+
+            if ( (x + kerning + glyph.x_advance) > max_width && pos > line_start ) {
+                if ( has_break && break_end > line_start ) {
+                    // break at last space run and carry current word over to next line
+                    font2c_emit_line(lines, max_lines, &n_lines, line_start, break_end, break_width);
+                    line_start = resume;
+                    x -= resume_x;
+                    has_break = false;
+                } else {
+                    // no space run on this line, so break word before current character
+                    font2c_emit_line(lines, max_lines, &n_lines, line_start, pos, x);
+                    line_start = pos;
+                    x = 0;
+                    kerning = 0;
+                }
+            }
+
+            x += kerning + glyph.x_advance;
+        }
+
+        prev_index = index;
+        prev_font = shard;
+    }
+
+    // a final line break has already ended the last line
+    if ( in_space ) {
+        font2c_emit_line(lines, max_lines, &n_lines, line_start, break_end, break_width);
+    } else if ( line_start < length ) {
+        font2c_emit_line(lines, max_lines, &n_lines, line_start, (uint32_t) length, x);
+    }
+
+    return n_lines;
+}
+
+
+static inline uint8_t font2c_expand(uint32_t value, uint8_t depth) {
+    switch(depth) {
+    case 1: return value ? 0xFF : 0x00;
+    case 2: return (uint8_t) (value * 0x55);
+    case 4: return (uint8_t) (value * 0x11);
+    case 8: return (uint8_t) value;
+    default: return (uint8_t) (((value * 255) + ((1u << depth) >> 1)) / ((1u << depth) - 1));
+    }
+}
+
+
+static inline void font2c_bitmap_init(font2c_bitmap_t* bitmap, const font2c_font_t* font, const font2c_glyph_t* glyph) {
+    bitmap->data = font2c_glyph_pixels(font, glyph);
+    bitmap->tiles = NULL;
+    bitmap->plane_size = 0;
+
+    if ( font->flags & FONT2C_FLAG_TILED ) {
+        font2c_glyph_t tile = *glyph;
+        uint32_t cols;
+        uint32_t rows;
+
+        tile.width = font->tile_width;
+        tile.height = font->tile_height;
+
+        // lines only run as far as the edge of each tile, so rows must be addressed pixel by pixel
+        bitmap->data = font->pixels;
+        bitmap->tiles = font2c_glyph_tiles(font, glyph, &cols, &rows);
+        bitmap->tile_cols = (uint16_t) cols;
+        bitmap->tile_width = font->tile_width;
+        bitmap->tile_height = font->tile_height;
+        bitmap->tile_size = font->tile_size;
+        bitmap->stride = 0;
+        bitmap->bit_offset = 0;
+        bitmap->line_bits = font2c_glyph_stride(font, &tile) * 8;
+
+        if ( font->flags & FONT2C_FLAG_PLANAR ) {
+            bitmap->plane_size = font2c_plane_size(font, &tile);
+        }
+    } else if ( font->flags & FONT2C_FLAG_BITSTREAM ) {
+        bitmap->bit_offset = glyph->offset & 7;
+        bitmap->line_bits = font2c_line_length(font, glyph) * font2c_glyph_depth(font, glyph);
+        bitmap->stride = (!bitmap->bit_offset && !(bitmap->line_bits & 7)) ? (bitmap->line_bits / 8) : 0;
+    } else {
+        bitmap->stride = font2c_glyph_stride(font, glyph);
+        bitmap->bit_offset = 0;
+        bitmap->line_bits = bitmap->stride * 8;
+
+        if ( font->flags & FONT2C_FLAG_PLANAR ) {
+            bitmap->plane_size = font2c_plane_size(font, glyph);
+        }
+    }
+
+    bitmap->width = glyph->width;
+    bitmap->height = glyph->height;
+    bitmap->depth = font2c_glyph_depth(font, glyph);
+    bitmap->levels = (bitmap->depth == font->depth) ? font->levels : NULL;
+    bitmap->msb_first = (font->flags & FONT2C_FLAG_MSB_FIRST) != 0;
+    bitmap->raster = font->raster;
+}
+
+
+static inline uint32_t font2c_bits_get(const uint8_t* data, uint32_t bit, uint8_t depth, bool msb_first) {
+    const uint8_t* p = data + (bit >> 3);
+    uint32_t shift = bit & 7;
+    uint32_t mask = (1u << depth) - 1;
+
+    if ( (shift + depth) <= 8 ) {
+        return (p[0] >> (msb_first ? (8 - depth - shift) : shift)) & mask;
+    }
+
+    // value straddles a byte boundary (depths other than 1, 2, 4 and 8)
+    if ( msb_first ) {
+        return ((((uint32_t) p[0] << 8) | p[1]) >> (16 - depth - shift)) & mask;
+    } else {
+        return ((p[0] | ((uint32_t) p[1] << 8)) >> shift) & mask;
+    }
+}
+
+
+static inline uint8_t font2c_bitmap_level(const font2c_bitmap_t* bitmap, uint32_t value) {
+    // fonts quantized to non-uniform levels carry a table mapping each pixel value to its coverage
+    return bitmap->levels ? bitmap->levels[value] : font2c_expand(value, bitmap->depth);
+}
+
+
+static inline uint32_t font2c_bitmap_value(const font2c_bitmap_t* bitmap, const uint8_t* line, uint32_t pos) {
+    return font2c_bits_get(line, pos * bitmap->depth, bitmap->depth, bitmap->msb_first);
+}
+
+
+static inline const uint8_t* font2c_bitmap_locate(const font2c_bitmap_t* bitmap, int32_t x, int32_t y, uint32_t* bit) {
+    const uint8_t* data = bitmap->data;
+    uint32_t depth = bitmap->plane_size ? 1 : bitmap->depth;
+    uint32_t line;
+    uint32_t pos;
+    int32_t w = bitmap->width;
+    int32_t h = bitmap->height;
+
+    if ( bitmap->tiles ) {
+        uint32_t tile = bitmap->tiles[((y / bitmap->tile_height) * bitmap->tile_cols) + (x / bitmap->tile_width)];
+
+        data += tile * bitmap->tile_size;
+        x %= bitmap->tile_width;
+        y %= bitmap->tile_height;
+        w = bitmap->tile_width;
+        h = bitmap->tile_height;
+    }
+
+    switch(bitmap->raster) {
+    default:
+    case FONT2C_RASTER_LRTB: line = y;         pos = x;         break;
+    case FONT2C_RASTER_RLTB: line = y;         pos = w - 1 - x; break;
+    case FONT2C_RASTER_LRBT: line = h - 1 - y; pos = x;         break;
+    case FONT2C_RASTER_RLBT: line = h - 1 - y; pos = w - 1 - x; break;
+    case FONT2C_RASTER_TBLR: line = x;         pos = y;         break;
+    case FONT2C_RASTER_TBRL: line = w - 1 - x; pos = y;         break;
+    case FONT2C_RASTER_BTLR: line = x;         pos = h - 1 - y; break;
+    case FONT2C_RASTER_BTRL: line = w - 1 - x; pos = h - 1 - y; break;
+    case FONT2C_RASTER_PAGE: line = y / (8 / depth);
+                             pos = (x * (8 / depth)) + (y % (8 / depth)); break;
+    }
+
+    *bit = bitmap->bit_offset + (line * bitmap->line_bits) + (pos * depth);
+
+    return data;
+}
+
+
+static inline uint8_t font2c_bitmap_get(const font2c_bitmap_t* bitmap, int32_t x, int32_t y) {
+    uint32_t bit;
+    const uint8_t* data = font2c_bitmap_locate(bitmap, x, y, &bit);
+    uint32_t value = 0;
+    uint8_t plane;
+
+    if ( !bitmap->plane_size ) {
+        return font2c_bitmap_level(bitmap, font2c_bits_get(data, bit, bitmap->depth, bitmap->msb_first));
+    }
+
+    // gather one bit from each plane, least-significant plane first
+    for (plane = 0; plane < bitmap->depth; plane++) {
+        value |= font2c_bits_get(data + (plane * bitmap->plane_size), bit, 1, bitmap->msb_first) << plane;
+    }
+
+    return font2c_bitmap_level(bitmap, value);
+}
+
+
+static inline void font2c_decode_line(const font2c_bitmap_t* bitmap, const uint8_t* line, int32_t pos, int32_t delta,
+                                      int32_t n, uint8_t* coverage) {
+    if ( bitmap->depth == 8 && delta > 0 && !bitmap->levels ) {
+        const uint8_t* src = line + pos;
+
+        while (n--) {
+            *coverage++ = *src++;
+        }
+    } else {
+        while (n--) {
+            *coverage++ = font2c_bitmap_level(bitmap, font2c_bitmap_value(bitmap, line, (uint32_t) pos));
+            pos += delta;
+        }
+    }
+}
+
+
+static inline void font2c_bitmap_row(const font2c_bitmap_t* bitmap, int32_t x, int32_t y, int32_t n, uint8_t* coverage) {
+    const uint8_t* line;
+    int32_t pos;
+    int32_t delta;
+
+    if ( !bitmap->stride || bitmap->plane_size ) {
+        // lines of bitstream, tiled and planar glyphs are not contiguous, so pixels are addressed individually
+        while (n--) {
+            *coverage++ = font2c_bitmap_get(bitmap, x++, y);
+        }
+
+        return;
+    }
+
+    switch(bitmap->raster) {
+    case FONT2C_RASTER_LRTB: line = bitmap->data + (y * bitmap->stride);                        pos = x; delta = 1; break;
+    case FONT2C_RASTER_LRBT: line = bitmap->data + ((bitmap->height - 1 - y) * bitmap->stride); pos = x; delta = 1; break;
+    case FONT2C_RASTER_RLTB: line = bitmap->data + (y * bitmap->stride); pos = bitmap->width - 1 - x; delta = -1; break;
+    case FONT2C_RASTER_RLBT: line = bitmap->data + ((bitmap->height - 1 - y) * bitmap->stride);
+                             pos = bitmap->width - 1 - x; delta = -1; break;
+
+    default:
+        // column-major orders have no contiguous rows, so fall back to addressing each pixel
+        while (n--) {
+            *coverage++ = font2c_bitmap_get(bitmap, x++, y);
+        }
+
+        return;
+    }
+
+    font2c_decode_line(bitmap, line, pos, delta, n, coverage);
+}
+
+
+static inline void font2c_surface_init(font2c_surface_t* surface, void* pixels, font2c_format_t format,
+                                       int16_t width, int16_t height, uint32_t pitch) {
+    surface->pixels = (uint8_t*) pixels;
+    surface->pitch = pitch;
+    surface->width = width;
+    surface->height = height;
+    surface->format = format;
+    surface->clip_x1 = 0;
+    surface->clip_y1 = 0;
+    surface->clip_x2 = width;
+    surface->clip_y2 = height;
+}
+
+
+static inline void font2c_page_blit(uint8_t* pages, int32_t width, int32_t n_pages, const font2c_font_t* font,
+                                    const font2c_glyph_t* glyph, int32_t x, int32_t y) {
+    const uint8_t* line = font2c_glyph_pixels(font, glyph);
+    uint32_t stride = font2c_glyph_stride(font, glyph);
+    bool msb_first = (font->flags & FONT2C_FLAG_MSB_FIRST) != 0;
+    int32_t page_height = 8 / font->depth;
+    int32_t top = y - glyph->y_bearing;
+    int32_t page = (top >= 0) ? (top / page_height) : -((page_height - 1 - top) / page_height);
+    uint32_t shift = (uint32_t) (top - (page * page_height)) * font->depth;
+    int32_t n = glyph->height / page_height;
+    int32_t gx = x + glyph->x_bearing;
+    int32_t x1 = (gx > 0) ? gx : 0;
+    int32_t x2 = (gx + glyph->width < width) ? (gx + glyph->width) : width;
+    int32_t cx;
+
+    if ( font->raster != FONT2C_RASTER_PAGE || (font->flags & (FONT2C_FLAG_TILED | FONT2C_FLAG_PLANAR)) ) {
+        return;
+    }
+
+    // each source page straddles two destination pages unless glyph's top lies on a page boundary
+    for (; n--; page++, line += stride) {
+        for (cx = x1; cx < x2; cx++) {
+            uint32_t b = line[cx - gx];
+
+            if ( page >= 0 && page < n_pages ) {
+                pages[(page * width) + cx] |= (uint8_t) (msb_first ? (b >> shift) : (b << shift));
+            }
+
+            if ( shift && (page + 1) >= 0 && (page + 1) < n_pages ) {
+                pages[((page + 1) * width) + cx] |= (uint8_t) (msb_first ? (b << (8 - shift)) : (b >> (8 - shift)));
+            }
+        }
+    }
+}
+
+
+static inline void font2c_surface_set_clip(font2c_surface_t* surface, int16_t x, int16_t y, int16_t width,
+                                           int16_t height) {
+    int32_t x2 = x + width;
+    int32_t y2 = y + height;
+
+    surface->clip_x1 = (x < 0) ? 0 : x;
+    surface->clip_y1 = (y < 0) ? 0 : y;
+    surface->clip_x2 = (int16_t) ((x2 > surface->width) ? surface->width : x2);
+    surface->clip_y2 = (int16_t) ((y2 > surface->height) ? surface->height : y2);
+}
+
+
+static inline uint32_t font2c_mix(uint32_t dst, uint32_t src, uint32_t alpha) {
+    uint32_t v = (src * alpha) + (dst * (255 - alpha)) + 128;
+
+    return (v + (v >> 8)) >> 8;
+}
+
+
+static inline void font2c_blend_row(font2c_surface_t* surface, int32_t x, int32_t y, const uint8_t* coverage,
+                                    int32_t n, uint32_t color) {
+    uint8_t* row = surface->pixels + ((uint32_t) y * surface->pitch);
+    int32_t i;
+
+    switch(surface->format) {
+    case FONT2C_FORMAT_MONO:
+        for (i = 0; i < n; i++, x++) {
+            if ( coverage[i] & 0x80 ) {
+                uint8_t bit = (uint8_t) (0x80 >> (x & 7));
+
+                if ( color ) {
+                    row[x >> 3] |= bit;
+                } else {
+                    row[x >> 3] &= (uint8_t) ~bit;
+                }
+            }
+        }
+        break;
+
+    case FONT2C_FORMAT_GRAY8: {
+        uint8_t* dst = row + x;
+
+        for (i = 0; i < n; i++) {
+            uint32_t a = coverage[i];
+
+            if ( a == 255 ) {
+                dst[i] = (uint8_t) color;
+            } else if ( a ) {
+                dst[i] = (uint8_t) font2c_mix(dst[i], color & 0xFF, a);
+            }
+        }
+        break;
+    }
+
+    case FONT2C_FORMAT_RGB565: {
+        // rows need not be aligned (the pitch is the caller's), so native words are loaded and stored via memcpy
+        uint8_t* dst = row + (2 * x);
+        uint32_t sr = (color >> 11) & 0x1F;
+        uint32_t sg = (color >> 5) & 0x3F;
+        uint32_t sb = color & 0x1F;
+        uint16_t v = (uint16_t) color;
+
+        for (i = 0; i < n; i++, dst += 2) {
+            uint32_t a = coverage[i];
+
+            if ( a == 255 ) {
+                memcpy(dst, &v, 2);
+            } else if ( a ) {
+                uint16_t d;
+                uint32_t r;
+                uint32_t g;
+                uint32_t b;
+                uint16_t mixed;
+
+                memcpy(&d, dst, 2);
+                r = font2c_mix((d >> 11) & 0x1F, sr, a);
+                g = font2c_mix((d >> 5) & 0x3F, sg, a);
+                b = font2c_mix(d & 0x1F, sb, a);
+                mixed = (uint16_t) ((r << 11) | (g << 5) | b);
+                memcpy(dst, &mixed, 2);
+            }
+        }
+        break;
+    }
+
+    case FONT2C_FORMAT_RGB888: {
+        uint8_t* dst = row + (3 * x);
+        uint32_t sr = (color >> 16) & 0xFF;
+        uint32_t sg = (color >> 8) & 0xFF;
+        uint32_t sb = color & 0xFF;
+
+        for (i = 0; i < n; i++, dst += 3) {
+            uint32_t a = coverage[i];
+
+            if ( a == 255 ) {
+                dst[0] = (uint8_t) sr;
+                dst[1] = (uint8_t) sg;
+                dst[2] = (uint8_t) sb;
+            } else if ( a ) {
+                dst[0] = (uint8_t) font2c_mix(dst[0], sr, a);
+                dst[1] = (uint8_t) font2c_mix(dst[1], sg, a);
+                dst[2] = (uint8_t) font2c_mix(dst[2], sb, a);
+            }
+        }
+        break;
+    }
+
+    case FONT2C_FORMAT_ARGB8888: {
+        uint8_t* dst = row + (4 * x);
+
+        for (i = 0; i < n; i++, dst += 4) {
+            uint32_t a = coverage[i];
+
+            if ( a == 255 ) {
+                memcpy(dst, &color, 4);
+            } else if ( a ) {
+                uint32_t d;
+                uint32_t v = 0;
+                uint32_t shift;
+
+                memcpy(&d, dst, 4);
+
+                for (shift = 0; shift < 32; shift += 8) {
+                    v |= font2c_mix((d >> shift) & 0xFF, (color >> shift) & 0xFF, a) << shift;
+                }
+
+                memcpy(dst, &v, 4);
+            }
+        }
+        break;
+    }
+    }
+}
+
+
+static inline bool font2c_clip(const font2c_surface_t* surface, int32_t* x1, int32_t* y1, int32_t* x2, int32_t* y2) {
+    if ( *x1 < surface->clip_x1 ) *x1 = surface->clip_x1;
+    if ( *y1 < surface->clip_y1 ) *y1 = surface->clip_y1;
+    if ( *x2 > surface->clip_x2 ) *x2 = surface->clip_x2;
+    if ( *y2 > surface->clip_y2 ) *y2 = surface->clip_y2;
+
+    return (*x1 < *x2) && (*y1 < *y2);
+}
+
+
+static inline void font2c_blit_coverage(font2c_surface_t* surface, int32_t x, int32_t y, int32_t width, int32_t height,
+                                        const uint8_t* coverage, uint32_t coverage_pitch, uint32_t color) {
+    int32_t x1 = x;
+    int32_t y1 = y;
+    int32_t x2 = x + width;
+    int32_t y2 = y + height;
+
+    if ( !font2c_clip(surface, &x1, &y1, &x2, &y2) ) {
+        return;
+    }
+
+    coverage += ((uint32_t) (y1 - y) * coverage_pitch) + (uint32_t) (x1 - x);
+
+    for (; y1 < y2; y1++) {
+        font2c_blend_row(surface, x1, y1, coverage, x2 - x1, color);
+        coverage += coverage_pitch;
+    }
+}
+
+
+static inline uint32_t font2c_mono_bits(const uint8_t* line, uint32_t bit, uint32_t n, bool msb_first) {
+    // gathers n (1 to 32) 1bpp pixels starting at bit into top of a word, leftmost pixel most-significant
+    const uint8_t* src = line + (bit >> 3);
+    uint32_t shift = bit & 7;
+    uint64_t bits;
+
+    if ( shift + n > 32 ) {
+        bits = ((uint64_t) src[0] << 56) | ((uint64_t) src[1] << 48) | ((uint64_t) src[2] << 40) |
+               ((uint64_t) src[3] << 32) | ((uint64_t) src[4] << 24);
+    } else {
+        uint32_t n_bytes = (shift + n + 7) >> 3;
+        uint32_t i;
+
+        // only bytes holding the requested pixels are read, so nothing beyond the end of the line is touched
+        bits = 0;
+
+        for (i = 0; i < n_bytes; i++) {
+            bits |= (uint64_t) src[i] << (56 - (i * 8));
+        }
+    }
+
+    if ( !msb_first ) {
+        // reverse bit order within every byte at once
+        bits = ((bits & 0xF0F0F0F0F0F0F0F0u) >> 4) | ((bits & 0x0F0F0F0F0F0F0F0Fu) << 4);
+        bits = ((bits & 0xCCCCCCCCCCCCCCCCu) >> 2) | ((bits & 0x3333333333333333u) << 2);
+        bits = ((bits & 0xAAAAAAAAAAAAAAAAu) >> 1) | ((bits & 0x5555555555555555u) << 1);
+    }
+
+    return (uint32_t) ((bits << shift) >> 32) & (uint32_t) (0xFFFFFFFF00000000u >> n);
+}
+
+
+static inline void font2c_blit_mono(font2c_surface_t* surface, const font2c_bitmap_t* bitmap, int32_t x1, int32_t y1,
+                                    int32_t x2, int32_t y2, int32_t gx, int32_t gy, uint32_t color) {
+    // 1bpp left-to-right source onto 1bpp target: shift and merge up to 32 pixels at a time, surface bytes
+    // being assembled into big-endian words so the leftmost pixel stays most-significant
+    const uint8_t* line = bitmap->data + ((uint32_t) (y1 - gy) * bitmap->stride);
+
+    for (; y1 < y2; y1++, line += bitmap->stride) {
+        uint8_t* row = surface->pixels + ((uint32_t) y1 * surface->pitch);
+        uint32_t src_bit = (uint32_t) (x1 - gx);
+        int32_t x = x1;
+
+        while (x < x2) {
+            uint32_t dst_shift = (uint32_t) x & 7;
+            uint32_t n = (uint32_t) (x2 - x);
+            uint8_t* dst = row + (x >> 3);
+            uint32_t bits;
+            uint32_t word;
+
+            if ( n > 32 - dst_shift ) {
+                n = 32 - dst_shift;
+            }
+
+            bits = font2c_mono_bits(line, src_bit, n, bitmap->msb_first) >> dst_shift;
+
+            if ( dst_shift + n == 32 ) {
+                word = ((uint32_t) dst[0] << 24) | ((uint32_t) dst[1] << 16) | ((uint32_t) dst[2] << 8) | dst[3];
+                word = color ? (word | bits) : (word & ~bits);
+                dst[0] = (uint8_t) (word >> 24);
+                dst[1] = (uint8_t) (word >> 16);
+                dst[2] = (uint8_t) (word >> 8);
+                dst[3] = (uint8_t) word;
+            } else {
+                // final partial word of row, touching only bytes that hold clipped pixels
+                uint32_t n_bytes = (dst_shift + n + 7) >> 3;
+                uint32_t i;
+
+                for (i = 0; i < n_bytes; i++) {
+                    uint8_t b = (uint8_t) (bits >> (24 - (i * 8)));
+
+                    dst[i] = (uint8_t) (color ? (dst[i] | b) : (dst[i] & ~b));
+                }
+            }
+
+            x += (int32_t) n;
+            src_bit += n;
+        }
+    }
+}
+
+
+static inline void font2c_blit_color(font2c_surface_t* surface, const font2c_bitmap_t* bitmap,
+                                     int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t gx, int32_t gy) {
+    uint32_t size = bitmap->depth / 8;
+
+    for (; y1 < y2; y1++) {
+        uint8_t* dst = surface->pixels + ((uint32_t) y1 * surface->pitch) + ((uint32_t) x1 * size);
+        int32_t cx;
+
+        if ( bitmap->stride && bitmap->raster == FONT2C_RASTER_LRTB ) {
+            // pixels are already in surface's format, so each clipped row is a straight copy
+            memcpy(dst, bitmap->data + ((uint32_t) (y1 - gy) * bitmap->stride) + ((uint32_t) (x1 - gx) * size),
+                   (uint32_t) (x2 - x1) * size);
+            continue;
+        }
+
+        for (cx = x1; cx < x2; cx++, dst += size) {
+            uint32_t bit;
+            const uint8_t* src = font2c_bitmap_locate(bitmap, cx - gx, y1 - gy, &bit);
+
+            memcpy(dst, src + (bit >> 3), size);
+        }
+    }
+}
+
+
+static inline void font2c_blit_glyph(font2c_surface_t* surface, const font2c_font_t* font,
+                                     const font2c_glyph_t* glyph, int32_t x, int32_t y, uint32_t color) {
+    font2c_bitmap_t bitmap;
+    uint8_t coverage[FONT2C_ROW_CHUNK];
+    int32_t gx = x + glyph->x_bearing;
+    int32_t gy = y - glyph->y_bearing;
+    int32_t x1 = gx;
+    int32_t y1 = gy;
+    int32_t x2 = gx + glyph->width;
+    int32_t y2 = gy + glyph->height;
+
+    if ( !font2c_clip(surface, &x1, &y1, &x2, &y2) ) {
+        return;
+    }
+
+    font2c_bitmap_init(&bitmap, font, glyph);
+
+    if ( font->flags & FONT2C_FLAG_COLOR ) {
+        // colours are baked into pixels, so color is ignored and only a matching surface can be drawn on
+        if ( surface->format == font->format ) {
+            font2c_blit_color(surface, &bitmap, x1, y1, x2, y2, gx, gy);
+        }
+
+        return;
+    }
+
+    if ( surface->format == FONT2C_FORMAT_MONO && bitmap.depth == 1 && bitmap.raster == FONT2C_RASTER_LRTB &&
+         bitmap.stride ) {
+        font2c_blit_mono(surface, &bitmap, x1, y1, x2, y2, gx, gy, color);
+        return;
+    }
+
+    for (; y1 < y2; y1++) {
+        int32_t cx;
+
+        for (cx = x1; cx < x2; cx += FONT2C_ROW_CHUNK) {
+            int32_t n = x2 - cx;
+
+            if ( n > FONT2C_ROW_CHUNK ) {
+                n = FONT2C_ROW_CHUNK;
+            }
+
+            font2c_bitmap_row(&bitmap, cx - gx, y1 - gy, n, coverage);
+            font2c_blend_row(surface, cx, y1, coverage, n, color);
+        }
+    }
+}
+
+
+static inline int32_t font2c_draw_utf8(font2c_surface_t* surface, const font2c_font_t* font, int32_t x, int32_t y,
+                                       const char* text, size_t length, uint32_t color) {
+    font2c_iter_t iter;
+    int32_t width = 0;
+
+    font2c_iter_init(&iter, font, text, length);
+
+    while ( font2c_iter_next(&iter) ) {
+        font2c_blit_glyph(surface, iter.glyph_font, &iter.glyph, x + iter.x, y + iter.y, color);
+
+        if ( iter.next_x > width ) {
+            width = iter.next_x;
+        }
+    }
+
+    return width;
+}
+
+
+static inline bool font2c_scanline_init(font2c_scanline_t* scanline, const font2c_font_t* font, int32_t x, int32_t y,
+                                        const char* text, size_t length, font2c_span_t* spans, size_t max_spans) {
+    const font2c_font_t* fallback;
+    font2c_iter_t iter;
+
+    scanline->spans = spans;
+    scanline->n_spans = 0;
+    scanline->y = 0;
+    scanline->y_end = 0;
+
+    // spans step through each glyph's rows exactly once, which requires top-to-bottom, contiguous rows held in
+    // memory, laid out the same way by every font in the fallback chain
+    for (fallback = font; fallback; fallback = fallback->fallback) {
+        if ( (fallback->raster != FONT2C_RASTER_LRTB && fallback->raster != FONT2C_RASTER_RLTB) ||
+             (fallback->flags & (FONT2C_FLAG_EXTERNAL | FONT2C_FLAG_BITSTREAM | FONT2C_FLAG_TILED |
+                                 FONT2C_FLAG_COLOR | FONT2C_FLAG_PLANAR)) ||
+             fallback->raster != font->raster || fallback->flags != font->flags ) {
+            return false;
+        }
+    }
+
+    font2c_iter_init(&iter, font, text, length);
+
+    while ( font2c_iter_next(&iter) ) {
+        font2c_span_t* span = &spans[scanline->n_spans];
+        int32_t top = y + iter.y - iter.glyph.y_bearing;
+        int32_t bottom = top + iter.glyph.height;
+
+        if ( !iter.glyph.width || !iter.glyph.height ) {
+            continue;
+        }
+
+        if ( scanline->n_spans == max_spans ) {
+            // leaves nothing to render rather than text with glyphs silently missing
+            scanline->n_spans = 0;
+            scanline->y = 0;
+            scanline->y_end = 0;
+            return false;
+        }
+
+        font2c_bitmap_init(&span->bitmap, iter.glyph_font, &iter.glyph);
+        span->x = x + iter.x + iter.glyph.x_bearing;
+        span->y = top;
+        span->line = span->bitmap.data;
+
+        if ( scanline->n_spans == 0 || top < scanline->y ) {
+            scanline->y = top;
+        }
+
+        if ( scanline->n_spans == 0 || bottom > scanline->y_end ) {
+            scanline->y_end = bottom;
+        }
+
+        scanline->n_spans++;
+    }
+
+    return true;
+}
+
+
+static inline bool font2c_scanline_render(font2c_scanline_t* scanline, uint8_t* coverage, int32_t width) {
+    uint8_t decoded[FONT2C_ROW_CHUNK];
+    int32_t y = scanline->y;
+    size_t i;
+
+    if ( y >= scanline->y_end ) {
+        return false;
+    }
+
+    for (i = 0; i < (size_t) width; i++) {
+        coverage[i] = 0;
+    }
+
+    for (i = 0; i < scanline->n_spans; i++) {
+        font2c_span_t* span = &scanline->spans[i];
+        const font2c_bitmap_t* bitmap = &span->bitmap;
+        int32_t x1;
+        int32_t x2;
+
+        if ( y < span->y || y >= (span->y + bitmap->height) ) {
+            continue;
+        }
+
+        x1 = (span->x < 0) ? 0 : span->x;
+        x2 = span->x + bitmap->width;
+
+        if ( x2 > width ) {
+            x2 = width;
+        }
+
+        while (x1 < x2) {
+            int32_t n = x2 - x1;
+            int32_t pos = x1 - span->x;
+            int32_t j;
+
+            if ( n > FONT2C_ROW_CHUNK ) {
+                n = FONT2C_ROW_CHUNK;
+            }
+
+            if ( bitmap->raster == FONT2C_RASTER_RLTB ) {
+                font2c_decode_line(bitmap, span->line, bitmap->width - 1 - pos, -1, n, decoded);
+            } else {
+                font2c_decode_line(bitmap, span->line, pos, 1, n, decoded);
+            }
+
+            for (j = 0; j < n; j++) {
+                if ( decoded[j] > coverage[x1 + j] ) {
+                    coverage[x1 + j] = decoded[j];
+                }
+            }
+
+            x1 += n;
+        }
+
+        span->line += bitmap->stride;
+    }
+
+    scanline->y++;
+    return true;
+}
+
+
+static inline void font2c_fill_rect(font2c_surface_t* surface, int32_t x, int32_t y, int32_t width, int32_t height,
+                                    uint32_t color) {
+    uint8_t opaque[FONT2C_ROW_CHUNK];
+    int32_t x1 = x;
+    int32_t y1 = y;
+    int32_t x2 = x + width;
+    int32_t y2 = y + height;
+    int32_t i;
+
+    if ( !font2c_clip(surface, &x1, &y1, &x2, &y2) ) {
+        return;
+    }
+
+    for (i = 0; i < FONT2C_ROW_CHUNK; i++) {
+        opaque[i] = 0xFF;
+    }
+
+    for (; y1 < y2; y1++) {
+        int32_t cx;
+
+        for (cx = x1; cx < x2; cx += FONT2C_ROW_CHUNK) {
+            int32_t n = x2 - cx;
+
+            font2c_blend_row(surface, cx, y1, opaque, (n > FONT2C_ROW_CHUNK) ? FONT2C_ROW_CHUNK : n, color);
+        }
+    }
+}
+
+
+static inline void font2c_label_init(font2c_label_t* label, const font2c_font_t* font, int32_t x, int32_t y,
+                                     font2c_cell_t* cells, size_t max_cells) {
+    label->font = font;
+    label->cells = cells;
+    label->max_cells = max_cells;
+    label->n_cells = 0;
+    label->x = x;
+    label->y = y;
+}
+
+
+static inline void font2c_label_dirty(const font2c_label_t* label, int32_t x1, int32_t x2,
+                                      font2c_rect_t* dirty, size_t max_dirty, size_t* n_dirty) {
+    x1 += label->x;
+    x2 += label->x;
+
+    if ( x1 >= x2 || !max_dirty ) {
+        return;
+    }
+
+    if ( *n_dirty > 0 ) {
+        font2c_rect_t* last = &dirty[*n_dirty - 1];
+        int32_t last_x2 = last->x + last->width;
+
+        // merge with previous rectangle if touching, or if out of rectangles
+        if ( (x1 <= last_x2 && x2 >= last->x) || *n_dirty == max_dirty ) {
+            if ( x1 < last->x ) last->x = x1;
+            if ( x2 > last_x2 ) last_x2 = x2;
+            last->width = last_x2 - last->x;
+            return;
+        }
+    }
+
+    dirty[*n_dirty].x = x1;
+    dirty[*n_dirty].y = label->y - label->font->ascent;
+    dirty[*n_dirty].width = x2 - x1;
+    dirty[*n_dirty].height = label->font->ascent + label->font->descent;
+    (*n_dirty)++;
+}
+
+
+static inline size_t font2c_label_update(font2c_label_t* label, const char* text, size_t length,
+                                         font2c_rect_t* dirty, size_t max_dirty) {
+    font2c_iter_t iter;
+    size_t n_dirty = 0;
+    size_t n_cells = 0;
+    size_t i;
+
+    font2c_iter_init(&iter, label->font, text, length);
+
+    // old layout of each cell is only needed until new layout overwrites it, so compare and replace in one pass
+    while ( n_cells < label->max_cells && font2c_iter_next(&iter) && iter.line == 0 ) {
+        font2c_cell_t* cell = &label->cells[n_cells];
+        int32_t x1 = iter.x + iter.glyph.x_bearing;
+        int32_t x2 = x1 + iter.glyph.width;
+
+        if ( iter.x < x1 || !iter.glyph.width ) x1 = iter.x;
+        if ( iter.next_x > x2 || !iter.glyph.width ) x2 = iter.next_x;
+
+        if ( n_cells >= label->n_cells ) {
+            font2c_label_dirty(label, x1, x2, dirty, max_dirty, &n_dirty);
+        } else if ( cell->codepoint != iter.codepoint || cell->x != iter.x ) {
+            font2c_label_dirty(label, (cell->x1 < x1) ? cell->x1 : x1, (cell->x2 > x2) ? cell->x2 : x2,
+                               dirty, max_dirty, &n_dirty);
+        }
+
+        cell->codepoint = iter.codepoint;
+        cell->x = iter.x;
+        cell->x1 = x1;
+        cell->x2 = x2;
+        n_cells++;
+    }
+
+    for (i = n_cells; i < label->n_cells; i++) {
+        font2c_label_dirty(label, label->cells[i].x1, label->cells[i].x2, dirty, max_dirty, &n_dirty);
+    }
+
+    label->n_cells = n_cells;
+    return n_dirty;
+}
+
+
+static inline void font2c_label_draw(const font2c_label_t* label, font2c_surface_t* surface,
+                                     const font2c_rect_t* dirty, size_t n_dirty, uint32_t color, uint32_t background) {
+    int16_t clip_x1 = surface->clip_x1;
+    int16_t clip_y1 = surface->clip_y1;
+    int16_t clip_x2 = surface->clip_x2;
+    int16_t clip_y2 = surface->clip_y2;
+    size_t i;
+    size_t j;
+
+    for (i = 0; i < n_dirty; i++) {
+        const font2c_rect_t* r = &dirty[i];
+
+        font2c_fill_rect(surface, r->x, r->y, r->width, r->height, background);
+
+        // neighbouring glyphs may overhang into dirty area, so redraw every cell that touches it
+        font2c_surface_set_clip(surface, (int16_t) r->x, (int16_t) r->y, (int16_t) r->width, (int16_t) r->height);
+
+        if ( surface->clip_x1 < clip_x1 ) surface->clip_x1 = clip_x1;
+        if ( surface->clip_y1 < clip_y1 ) surface->clip_y1 = clip_y1;
+        if ( surface->clip_x2 > clip_x2 ) surface->clip_x2 = clip_x2;
+        if ( surface->clip_y2 > clip_y2 ) surface->clip_y2 = clip_y2;
+
+        for (j = 0; j < label->n_cells; j++) {
+            const font2c_cell_t* cell = &label->cells[j];
+            const font2c_font_t* shard;
+            font2c_glyph_t glyph;
+
+            if ( (label->x + cell->x2) <= r->x || (label->x + cell->x1) >= (r->x + r->width) ) {
+                continue;
+            }
+
+            shard = font2c_find_font(label->font, cell->codepoint, &glyph);
+
+            if ( shard ) {
+                font2c_blit_glyph(surface, shard, &glyph, label->x + cell->x, label->y, color);
+            }
+        }
+
+        surface->clip_x1 = clip_x1;
+        surface->clip_y1 = clip_y1;
+        surface->clip_x2 = clip_x2;
+        surface->clip_y2 = clip_y2;
+    }
+}
+
+
+static inline void font2c_cache_init(font2c_cache_t* cache, const font2c_font_t* font, font2c_cache_entry_t* entries,
+                                     uint32_t n_entries, uint8_t* pool, uint32_t slot_size) {
+    uint32_t i;
+
+    cache->font = font;
+    cache->entries = entries;
+    cache->n_entries = n_entries;
+    cache->slot_size = slot_size;
+    cache->hand = 0;
+    cache->hits = 0;
+    cache->misses = 0;
+
+    for (i = 0; i < n_entries; i++) {
+        entries[i].codepoint = 0;
+        entries[i].coverage = pool + (i * slot_size);
+        entries[i].valid = false;
+        entries[i].referenced = false;
+    }
+}
+
+
+static inline const uint8_t* font2c_cache_get(font2c_cache_t* cache, const font2c_glyph_t* glyph) {
+    font2c_cache_entry_t* entry;
+    font2c_bitmap_t bitmap;
+    uint8_t* coverage;
+    uint32_t i;
+    int32_t y;
+
+    for (i = 0; i < cache->n_entries; i++) {
+        entry = &cache->entries[i];
+
+        if ( entry->valid && entry->codepoint == glyph->codepoint ) {
+            entry->referenced = true;
+            cache->hits++;
+            return entry->coverage;
+        }
+    }
+
+    cache->misses++;
+
+    if ( !cache->n_entries || ((uint32_t) glyph->width * glyph->height) > cache->slot_size ||
+         (cache->font->flags & FONT2C_FLAG_COLOR) ) {
+        return NULL;
+    }
+
+    // CLOCK eviction: skip over (and clear) referenced entries until an unreferenced one is found
+    for (;;) {
+        entry = &cache->entries[cache->hand];
+        cache->hand = (cache->hand + 1) % cache->n_entries;
+
+        if ( !entry->valid || !entry->referenced ) {
+            break;
+        }
+
+        entry->referenced = false;
+    }
+
+    font2c_bitmap_init(&bitmap, cache->font, glyph);
+    coverage = entry->coverage;
+
+    for (y = 0; y < glyph->height; y++) {
+        font2c_bitmap_row(&bitmap, 0, y, glyph->width, coverage);
+        coverage += glyph->width;
+    }
+
+    entry->codepoint = glyph->codepoint;
+    entry->valid = true;
+    entry->referenced = true;
+
+    return entry->coverage;
+}
+
+
+static inline void font2c_blit_cached(font2c_surface_t* surface, font2c_cache_t* cache,
+                                      const font2c_glyph_t* glyph, int32_t x, int32_t y, uint32_t color) {
+    const uint8_t* coverage = font2c_cache_get(cache, glyph);
+
+    if ( coverage ) {
+        font2c_blit_coverage(surface, x + glyph->x_bearing, y - glyph->y_bearing, glyph->width, glyph->height,
+                             coverage, glyph->width, color);
+    } else {
+        font2c_blit_glyph(surface, cache->font, glyph, x, y, color);
+    }
+}
+
+
+static inline int32_t font2c_draw_utf8_cached(font2c_surface_t* surface, font2c_cache_t* cache, int32_t x, int32_t y,
+                                              const char* text, size_t length, uint32_t color) {
+    font2c_iter_t iter;
+    int32_t width = 0;
+
+    font2c_iter_init(&iter, cache->font, text, length);
+
+    while ( font2c_iter_next(&iter) ) {
+        if ( iter.glyph_font == cache->font ) {
+            font2c_blit_cached(surface, cache, &iter.glyph, x + iter.x, y + iter.y, color);
+        } else {
+            // cache only holds glyphs of its own font, so glyphs from fallbacks are drawn directly
+            font2c_blit_glyph(surface, iter.glyph_font, &iter.glyph, x + iter.x, y + iter.y, color);
+        }
+
+        if ( iter.next_x > width ) {
+            width = iter.next_x;
+        }
+    }
+
+    return width;
+}
+
+
+
+static inline size_t font2c_run_init(font2c_run_t* run, const font2c_font_t* font, const char* text, size_t length,
+                                     font2c_run_glyph_t* glyphs, size_t max_glyphs) {
+    font2c_iter_t iter;
+    size_t n = 0;
+
+    run->font = *font;
+    run->glyphs = glyphs;
+    run->n_glyphs = 0;
+    run->width = 0;
+    run->size = 0;
+    run->n_reads = 0;
+
+    font2c_iter_init(&iter, font, text, length);
+
+    while ( font2c_iter_next(&iter) ) {
+        // runs fetch from one font's pixel data, so glyphs found in fallbacks are left out
+        if ( iter.glyph_font != font ) {
+            continue;
+        }
+
+        if ( n < max_glyphs ) {
+            glyphs[n].glyph = iter.glyph;
+            glyphs[n].x = iter.x;
+            glyphs[n].y = iter.y;
+            run->n_glyphs = n + 1;
+        }
+
+        if ( iter.next_x > run->width ) {
+            run->width = iter.next_x;
+        }
+
+        n++;
+    }
+
+    return n;
+}
+
+
+static inline bool font2c_run_fetch(font2c_run_t* run, font2c_read_t read, void* context, uint8_t* buffer,
+                                    uint32_t buffer_size, uint32_t max_gap) {
+    font2c_run_glyph_t* glyphs = run->glyphs;
+    size_t n = run->n_glyphs;
+    size_t i;
+    size_t j;
+
+    // insertion sort by source offset, runs are short and often nearly ordered already
+    for (i = 1; i < n; i++) {
+        font2c_run_glyph_t g = glyphs[i];
+
+        for (j = i; j > 0 && glyphs[j - 1].glyph.offset > g.glyph.offset; j--) {
+            glyphs[j] = glyphs[j - 1];
+        }
+
+        glyphs[j] = g;
+    }
+
+    run->size = 0;
+    run->n_reads = 0;
+
+    for (i = 0; i < n; i = j) {
+        uint32_t start = glyphs[i].glyph.offset;
+        uint32_t end = start + font2c_glyph_size(&run->font, &glyphs[i].glyph);
+
+        // extend read over following glyphs that overlap it or lie within max_gap bytes of its end
+        for (j = i + 1; j < n; j++) {
+            uint32_t offset = glyphs[j].glyph.offset;
+            uint32_t glyph_end = offset + font2c_glyph_size(&run->font, &glyphs[j].glyph);
+
+            if ( offset > end && (offset - end) > max_gap ) {
+                break;
+            }
+
+            if ( glyph_end > end ) {
+                end = glyph_end;
+            }
+        }
+
+        if ( end > start ) {
+            if ( (end - start) > (buffer_size - run->size) ) {
+                return false;
+            }
+
+            if ( !read(context, start, buffer + run->size, end - start) ) {
+                return false;
+            }
+
+            run->n_reads++;
+        }
+
+        for (; i < j; i++) {
+            glyphs[i].glyph.offset = run->size + (glyphs[i].glyph.offset - start);
+        }
+
+        run->size += end - start;
+    }
+
+    run->font.pixels = buffer;
+    run->font.flags &= ~FONT2C_FLAG_EXTERNAL;
+
+    return true;
+}
+
+
+static inline void font2c_run_draw(font2c_surface_t* surface, const font2c_run_t* run, int32_t x, int32_t y,
+                                   uint32_t color) {
+    size_t i;
+
+    for (i = 0; i < run->n_glyphs; i++) {
+        const font2c_run_glyph_t* g = &run->glyphs[i];
+
+        font2c_blit_glyph(surface, &run->font, &g->glyph, x + g->x, y + g->y, color);
+    }
+}
+
 #endif // _DOXYGEN
 
 #ifdef __cplusplus
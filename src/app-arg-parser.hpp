@@ -24,6 +24,7 @@
 #include <exception>
 #include <functional>
 #include <optional>
+#include <string>
 #include <vector>
 
 #include "app-error.hpp"
@@ -172,6 +173,17 @@ namespace app {
     }
 
 
+    template<>
+    inline void ArgParser::option(std::vector<std::string>& value, std::string_view value_name, char short_name,
+                                  std::string_view long_name, std::string_view description) {
+        // option may be repeated, each occurrence appending another value
+        add_option(short_name, long_name, description, value_name, true,
+                   [&](std::string_view name, std::string_view arg) {
+                       value.emplace_back(arg);
+                   });
+    }
+
+
     template<typename T>
     inline void ArgParser::option(T& value, std::string_view value_name, char short_name,
                                   std::string_view description) {
@@ -18,87 +18,268 @@
  * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <charconv>
 #include <filesystem>
-#include <fstream>
 #include <sstream>
 #include <string>
 
 #include "app-char-set.hpp"
+#include "app-mapped-file.hpp"
+#include "app-utf8.hpp"
 
 
-typedef std::istream_iterator<std::uint8_t> CharSetFileInput;
+using namespace app;
+
+
+CharSet::const_iterator::const_iterator(std::vector<Range>::const_iterator range,
+                                        std::vector<Range>::const_iterator end):
+    m_range(range),
+    m_end(end),
+    m_codepoint((range != end) ? range->first : 0) {
+}
+
+
+CharSet::CharSet():
+    m_ranges(),
+    m_size(0) {
+}
+
+
+CharSet::const_iterator CharSet::begin() const {
+    return const_iterator(m_ranges.begin(), m_ranges.end());
+}
+
+
+CharSet::const_iterator CharSet::end() const {
+    return const_iterator(m_ranges.end(), m_ranges.end());
+}
+
+
+size_t CharSet::count(char32_t codepoint) const {
+    auto i = std::upper_bound(m_ranges.begin(), m_ranges.end(), codepoint,
+                              [](char32_t c, const Range& range) { return c < range.first; });
+
+    return (i != m_ranges.begin() && codepoint <= (i - 1)->last) ? 1 : 0;
+}
+
+
+bool CharSet::empty() const {
+    return m_ranges.empty();
+}
+
+
+size_t CharSet::size() const {
+    return m_size;
+}
+
+
+const std::vector<CharSet::Range>& CharSet::ranges() const {
+    return m_ranges;
+}
+
+
+void CharSet::insert(char32_t codepoint) {
+    insert(codepoint, codepoint);
+}
+
+
+void CharSet::insert(char32_t first, char32_t last) {
+    // loaders mostly produce ascending codepoints, which extend or follow the last range
+    if ( m_ranges.empty() || first > m_ranges.back().last ) {
+        append({first, last});
+        return;
+    }
+
+    // otherwise merge every range overlapping or adjacent to [first, last] into one
+    auto lo = std::lower_bound(m_ranges.begin(), m_ranges.end(), first,
+                               [](const Range& range, char32_t c) { return range.last + 1 < c; });
+    auto hi = std::upper_bound(lo, m_ranges.end(), last,
+                               [](char32_t c, const Range& range) { return c + 1 < range.first; });
+
+    if ( lo == hi ) {
+        m_ranges.insert(lo, {first, last});
+        m_size += last - first + 1;
+        return;
+    }
+
+    Range merged = {std::min(first, lo->first), std::max(last, (hi - 1)->last)};
+
+    for (auto i = lo; i != hi; i++) {
+        m_size -= i->last - i->first + 1;
+    }
+
+    m_size += merged.last - merged.first + 1;
+    *lo = merged;
+    m_ranges.erase(lo + 1, hi);
+}
+
+
+void CharSet::append(Range range) {
+    assert(m_ranges.empty() || range.first >= m_ranges.back().first);
+
+    if ( !m_ranges.empty() && range.first <= m_ranges.back().last + 1 ) {
+        if ( range.last > m_ranges.back().last ) {
+            m_size += range.last - m_ranges.back().last;
+            m_ranges.back().last = range.last;
+        }
+    } else {
+        m_ranges.push_back(range);
+        m_size += range.last - range.first + 1;
+    }
+}
 
 
 app::CharSet app::char_set_default() {
     app::CharSet cs;
 
-    for (char32_t c = 32; c < 127; c++) {
-        cs.insert(c);
-    }
+    cs.insert(32, 126);
 
     return cs;
 }
 
 
-static void expect_input(CharSetFileInput& i, CharSetFileInput& e) {
-    if ( i == e ) {
-        throw app::Error("Encountered incomplete UTF-8 sequence");
+static app::CharSet load_txt(std::string_view path) {
+    app::MappedFile file(path);
+    std::u32string text;
+
+    try {
+        text = app::utf8_decode(file.text());
+    } catch (app::Error& e) {
+        throw app::Error("Invalid character set '{}': {}", path, e.what());
     }
+
+    // mark codepoints in a bitmap rather than sorting, then build the set in order in linear time
+    char32_t end = text.empty() ? 0 : (*std::max_element(text.begin(), text.end()) + 1);
+    std::vector<bool> present(end, false);
+    app::CharSet s;
+
+    for (auto c: text) {
+        present[c] = true;
+    }
+
+    for (char32_t c = 32; c < end; c++) {
+        if ( present[c] ) {
+            s.insert(c);
+        }
+    }
+
+    return s;
 }
 
 
-static app::CharSet load_txt(std::string_view path) {
-    static const uint8_t LENGTH_LUT[] = {
-            1, 1, 1, 1, 1, 1, 1, 1,
-            1, 1, 1, 1, 1, 1, 1, 1,
-            0, 0, 0, 0, 0, 0, 0, 0,
-            2, 2, 2, 2, 3, 3, 4, 0
-    };
+static void skip_space(std::string_view& s) {
+    while ( !s.empty() && (s.front() == ' ' || s.front() == '\t' || s.front() == '\r') ) {
+        s.remove_prefix(1);
+    }
+}
 
-    static const uint8_t MASK_LUT[] = {
-            0x00, 0x7f, 0x1f, 0x0f, 0x07
-    };
 
-    static const uint8_t SHIFT_C_LUT[] = {
-            0, 18, 12, 6, 0
-    };
+static bool parse_codepoint(std::string_view& s, char32_t& c) {
+    uint32_t value;
 
-    std::ifstream ifs(path.data());
+    if ( s.size() >= 2 && (s[0] == 'U' || s[0] == 'u') && s[1] == '+' ) {
+        s.remove_prefix(2);
+    } else if ( s.size() >= 2 && s[0] == '0' && (s[1] == 'x' || s[1] == 'X') ) {
+        s.remove_prefix(2);
+    }
 
-    ifs.unsetf(std::ios_base::skipws);
+    auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), value, 16);
 
-    CharSetFileInput input_i(ifs);
-    CharSetFileInput input_e;
-    app::CharSet s;
+    if ( ec != std::errc() ) {
+        return false;
+    }
+
+    s.remove_prefix(end - s.data());
+    skip_space(s);
+    c = value;
 
-    if (!ifs) {
-        throw app::Error("Unable to load character set '{}'", path);
+    return true;
+}
+
+
+// a codepoint, or an inclusive range such as "U+4E00..U+9FFF", "0x4E00-0x9FFF" or "4E00-9FFF", making up all of s
+static bool parse_range(std::string_view s, char32_t& first, char32_t& last) {
+    skip_space(s);
+
+    if ( !parse_codepoint(s, first) ) {
+        return false;
     }
 
-    while (input_i != input_e && ifs) {
-        uint8_t byte = *input_i++;
-        uint8_t len = LENGTH_LUT[byte >> 3];
-        auto c = static_cast<char32_t>((byte & MASK_LUT[len]) << 18);
+    last = first;
 
-        if (len > 1) {
-            expect_input(input_i, input_e);
-            c |= static_cast<char32_t>(*input_i++ & 0x3F) << 12;
+    if ( !s.empty() ) {
+        if ( s.compare(0, 2, "..") == 0 ) {
+            s.remove_prefix(2);
+        } else if ( s.front() == '-' ) {
+            s.remove_prefix(1);
+        } else {
+            return false;
         }
 
-        if (len > 2) {
-            expect_input(input_i, input_e);
-            c |= static_cast<char32_t>(*input_i++ & 0x3F) << 6;
+        skip_space(s);
+
+        if ( !parse_codepoint(s, last) ) {
+            return false;
         }
+    }
+
+    return s.empty() && first <= last && last <= 0x10FFFF;
+}
+
 
-        if (len > 3) {
-            expect_input(input_i, input_e);
-            c |= static_cast<char32_t>(*input_i++ & 0x3F);
+static app::CharSet load_hex(std::string_view path, app::DepthMap* depths) {
+    app::MappedFile file(path);
+    std::string_view text = file.text();
+    app::CharSet s;
+    size_t line_number = 0;
+    int depth = 0;
+
+    for (size_t pos = 0; pos < text.size();) {
+        size_t end = std::min(text.find('\n', pos), text.size());
+        std::string_view line = text.substr(pos, end - pos);
+        char32_t first;
+        char32_t last;
+
+        pos = end + 1;
+        line_number++;
+        line = line.substr(0, line.find('#'));
+        skip_space(line);
+
+        while ( !line.empty() && std::isspace(static_cast<unsigned char>(line.back())) ) {
+            line.remove_suffix(1);
+        }
+
+        if ( line.empty() ) {
+            continue;
         }
 
-        c >>= SHIFT_C_LUT[len];
+        // "@depth N" applies to codepoints that follow it, "@depth 0" restores the default depth
+        if ( line.compare(0, 6, "@depth") == 0 ) {
+            std::istringstream iss{std::string(line.substr(6))};
 
-        if (c >= 32) {
-            s.insert(c);
+            if ( !(iss >> depth) || depth < 0 || depth > 8 ) {
+                throw app::Error("Invalid depth directive in character set '{}': {}", path, line);
+            }
+
+            continue;
+        }
+
+        if ( !parse_range(line, first, last) ) {
+            throw app::Error("Invalid codepoint or range on line {} of character set '{}': {}", line_number, path,
+                             line);
+        }
+
+        s.insert(first, last);
+
+        if ( depths && depth > 0 ) {
+            if ( !depths->empty() && depths->back().last + 1 == first && depths->back().depth == depth ) {
+                depths->back().last = last;
+            } else {
+                depths->push_back({first, last, depth});
+            }
         }
     }
 
@@ -106,40 +287,124 @@ static app::CharSet load_txt(std::string_view path) {
 }
 
 
-static app::CharSet load_hex(std::string_view path) {
-    std::ifstream ifs(path.data());
-    app::CharSet s;
-    std::string line;
+app::CharSet app::char_set_load(std::string_view path, DepthMap* depths) {
+    if ( std::filesystem::path(path).extension() == ".hex" ) {
+        app::CharSet s = load_hex(path, depths);
+
+        if ( depths ) {
+            std::sort(depths->begin(), depths->end(),
+                      [](const DepthRange& a, const DepthRange& b) { return a.first < b.first; });
+        }
+
+        return s;
+    } else {
+        return load_txt(path);
+    }
+}
+
+
+void app::char_set_add_ranges(CharSet& char_set, std::string_view ranges) {
+    // comma-separated codepoints or ranges, written as in .hex character sets, e.g. "20-7E,B0,U+2013..U+2014"
+    for (size_t pos = 0; pos <= ranges.size();) {
+        size_t end = std::min(ranges.find(',', pos), ranges.size());
+        std::string_view range = ranges.substr(pos, end - pos);
+        char32_t first;
+        char32_t last;
+
+        pos = end + 1;
 
-    if (!ifs) {
-        throw app::Error("Unable to load character set '{}'", path);
+        if ( !parse_range(range, first, last) ) {
+            throw app::Error("Invalid codepoint range: {}", range);
+        }
+
+        char_set.insert(first, last);
     }
+}
+
+
+app::CharSet app::char_set_union(const CharSet& a, const CharSet& b) {
+    CharSet result;
+    auto i = a.ranges().begin();
+    auto j = b.ranges().begin();
 
-    while (std::getline(ifs, line)) {
-        try {
-            auto comment_pos = line.find('#');
+    // merge by first codepoint, letting append() coalesce overlapping ranges
+    while ( i != a.ranges().end() || j != b.ranges().end() ) {
+        if ( j == b.ranges().end() || (i != a.ranges().end() && i->first < j->first) ) {
+            result.append(*i++);
+        } else {
+            result.append(*j++);
+        }
+    }
+
+    return result;
+}
+
+
+app::CharSet app::char_set_intersection(const CharSet& a, const CharSet& b) {
+    CharSet result;
+    auto i = a.ranges().begin();
+    auto j = b.ranges().begin();
+
+    while ( i != a.ranges().end() && j != b.ranges().end() ) {
+        char32_t first = std::max(i->first, j->first);
+        char32_t last = std::min(i->last, j->last);
+
+        if ( first <= last ) {
+            result.append({first, last});
+        }
+
+        if ( i->last < j->last ) {
+            i++;
+        } else {
+            j++;
+        }
+    }
 
-            if ( comment_pos != std::string::npos ) {
-                line.resize(comment_pos);
+    return result;
+}
+
+
+app::CharSet app::char_set_difference(const CharSet& a, const CharSet& b) {
+    CharSet result;
+    auto j = b.ranges().begin();
+
+    for (const auto& range: a.ranges()) {
+        char32_t first = range.first;
+
+        while ( j != b.ranges().end() && j->last < first ) {
+            j++;
+        }
+
+        // carve each overlapping range of b out of this one, leaving j on the last of them for the next range
+        for (auto k = j; k != b.ranges().end() && k->first <= range.last; k++) {
+            if ( k->first > first ) {
+                result.append({first, k->first - 1});
+            }
+
+            first = k->last + 1;
+
+            if ( k->last >= range.last ) {
+                break;
             }
+        }
 
-            s.insert(std::stoul(line, nullptr, 16));
-        } catch(std::out_of_range&) {
-            // ignore
-        } catch(std::invalid_argument&) {
-            // ignore
+        if ( first <= range.last ) {
+            result.append({first, range.last});
         }
     }
 
-    return s;
+    return result;
 }
 
 
+int app::depth_lookup(const DepthMap& depths, char32_t codepoint, int default_depth) {
+    auto i = std::upper_bound(depths.begin(), depths.end(), codepoint,
+                              [](char32_t c, const DepthRange& range) { return c < range.first; });
 
-app::CharSet app::char_set_load(std::string_view path) {
-    if ( std::filesystem::path(path).extension() == ".hex" ) {
-        return load_hex(path);
-    } else {
-        return load_txt(path);
+    // ranges are sorted by first codepoint, so the only candidate is the one starting at or before codepoint
+    if ( i != depths.begin() && codepoint <= (i - 1)->last ) {
+        return (i - 1)->depth;
     }
+
+    return default_depth;
 }
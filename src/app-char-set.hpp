@@ -18,16 +18,130 @@
  * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
-#include <set>
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <map>
 #include <string_view>
+#include <vector>
 
 #include "app-error.hpp"
 
 
 namespace app {
-    typedef std::set<char32_t> CharSet;
+
+    // sorted, coalesced ranges of codepoints, iterated codepoint by codepoint in ascending order
+    class CharSet final {
+    public:
+
+        struct Range {
+            char32_t first;
+            char32_t last;
+        };
+
+        class const_iterator {
+        public:
+
+            typedef std::forward_iterator_tag iterator_category;
+            typedef char32_t value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef const char32_t* pointer;
+            typedef char32_t reference;
+
+            const_iterator(std::vector<Range>::const_iterator range, std::vector<Range>::const_iterator end);
+
+            char32_t operator*() const {
+                return m_codepoint;
+            }
+
+            const_iterator& operator++() {
+                if ( m_codepoint == m_range->last ) {
+                    ++m_range;
+                    m_codepoint = (m_range != m_end) ? m_range->first : 0;
+                } else {
+                    m_codepoint++;
+                }
+
+                return *this;
+            }
+
+            const_iterator operator++(int) {
+                const_iterator i = *this;
+
+                ++*this;
+                return i;
+            }
+
+            bool operator==(const const_iterator& i) const {
+                return m_range == i.m_range && m_codepoint == i.m_codepoint;
+            }
+
+            bool operator!=(const const_iterator& i) const {
+                return !(*this == i);
+            }
+
+        private:
+
+            std::vector<Range>::const_iterator m_range;
+            std::vector<Range>::const_iterator m_end;
+            char32_t m_codepoint;
+        };
+
+        CharSet();
+
+        [[nodiscard]]
+        const_iterator begin() const;
+
+        [[nodiscard]]
+        const_iterator end() const;
+
+        [[nodiscard]]
+        size_t count(char32_t codepoint) const;
+
+        [[nodiscard]]
+        bool empty() const;
+
+        [[nodiscard]]
+        size_t size() const;
+
+        [[nodiscard]]
+        const std::vector<Range>& ranges() const;
+
+        void insert(char32_t codepoint);
+
+        void insert(char32_t first, char32_t last);
+
+        void append(Range range);
+
+    private:
+
+        std::vector<Range> m_ranges;
+        size_t m_size;
+    };
+
+    typedef std::map<char32_t, uint64_t> CharCounts;
+
+    struct DepthRange {
+        char32_t first;
+        char32_t last;
+        int depth;
+    };
+
+    typedef std::vector<DepthRange> DepthMap;
 
     CharSet char_set_default();
 
-    CharSet char_set_load(std::string_view path);
+    CharSet char_set_load(std::string_view path, DepthMap* depths = nullptr);
+
+    void char_set_add_ranges(CharSet& char_set, std::string_view ranges);
+
+    CharSet char_set_union(const CharSet& a, const CharSet& b);
+
+    CharSet char_set_intersection(const CharSet& a, const CharSet& b);
+
+    CharSet char_set_difference(const CharSet& a, const CharSet& b);
+
+    int depth_lookup(const DepthMap& depths, char32_t codepoint, int default_depth);
 }
\ No newline at end of file
@@ -0,0 +1,107 @@
+/*
+ * font2c - Command-line utility for converting font glyphs into bitmap images
+ * embeddable in C source code.
+ *
+ * https://github.com/mattbucknall/font2c
+ *
+ * Copyright (C) 2022 Matthew T. Bucknall
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <charconv>
+#include <cmath>
+
+#include "app-color.hpp"
+
+
+int app::color_depth(std::string_view format) {
+    if ( format == "rgb565" ) {
+        return 16;
+    } else if ( format == "rgb888" ) {
+        return 24;
+    } else if ( format == "argb8888" ) {
+        return 32;
+    } else {
+        throw app::Error("Unsupported color format: {}", format);
+    }
+}
+
+
+uint32_t app::color_parse(std::string_view text) {
+    std::string_view digits = text;
+    uint32_t value;
+
+    if ( !digits.empty() && digits[0] == '#' ) {
+        digits.remove_prefix(1);
+    }
+
+    auto result = std::from_chars(digits.data(), digits.data() + digits.size(), value, 16);
+
+    if ( result.ec != std::errc() || result.ptr != (digits.data() + digits.size()) ||
+         (digits.size() != 6 && digits.size() != 8) ) {
+        throw app::Error("Invalid color (expected RRGGBB or AARRGGBB): {}", text);
+    }
+
+    // colours without an alpha component are opaque
+    return (digits.size() == 6) ? (value | 0xFF000000u) : value;
+}
+
+
+uint32_t app::color_convert(uint32_t argb, std::string_view format) {
+    uint32_t r = (argb >> 16) & 0xFF;
+    uint32_t g = (argb >> 8) & 0xFF;
+    uint32_t b = argb & 0xFF;
+
+    int depth = color_depth(format);
+
+    if ( depth == 16 ) {
+        return (((r * 31 + 127) / 255) << 11) | (((g * 63 + 127) / 255) << 5) | ((b * 31 + 127) / 255);
+    } else if ( depth == 24 ) {
+        return argb & 0xFFFFFF;
+    } else {
+        return argb;
+    }
+}
+
+
+std::vector<uint32_t> app::color_ramp(uint32_t fg, uint32_t bg, double gamma, int levels) {
+    std::vector<uint32_t> ramp;
+
+    auto channel = [](uint32_t color, int shift) {
+        return static_cast<double>((color >> shift) & 0xFF) / 255.0;
+    };
+
+    for (int i = 0; i < levels; i++) {
+        double a = static_cast<double>(i) / (levels - 1);
+        uint32_t color;
+
+        if ( (bg >> 24) == 0 ) {
+            // transparent background keeps foreground colour and carries coverage in alpha alone
+            color = (fg & 0xFFFFFF) | (static_cast<uint32_t>(std::lround(a * (fg >> 24))) << 24);
+        } else {
+            // blend in linear light, so that gamma > 1 keeps thin strokes from looking washed out
+            color = static_cast<uint32_t>(std::lround(((1.0 - a) * (bg >> 24)) + (a * (fg >> 24)))) << 24;
+
+            for (int shift = 0; shift < 24; shift += 8) {
+                double v = ((1.0 - a) * std::pow(channel(bg, shift), gamma)) +
+                           (a * std::pow(channel(fg, shift), gamma));
+
+                color |= static_cast<uint32_t>(std::lround(std::pow(v, 1.0 / gamma) * 255.0)) << shift;
+            }
+        }
+
+        ramp.push_back(color);
+    }
+
+    return ramp;
+}
@@ -0,0 +1,38 @@
+/*
+ * font2c - Command-line utility for converting font glyphs into bitmap images
+ * embeddable in C source code.
+ *
+ * https://github.com/mattbucknall/font2c
+ *
+ * Copyright (C) 2022 Matthew T. Bucknall
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "app-error.hpp"
+
+
+namespace app {
+    int color_depth(std::string_view format);
+
+    uint32_t color_parse(std::string_view text);
+
+    uint32_t color_convert(uint32_t argb, std::string_view format);
+
+    std::vector<uint32_t> color_ramp(uint32_t fg, uint32_t bg, double gamma, int levels);
+}
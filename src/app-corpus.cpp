@@ -0,0 +1,477 @@
+/*
+ * font2c - Command-line utility for converting font glyphs into bitmap images
+ * embeddable in C source code.
+ *
+ * https://github.com/mattbucknall/font2c
+ *
+ * Copyright (C) 2022 Matthew T. Bucknall
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <string>
+
+#include "app-corpus.hpp"
+#include "app-mapped-file.hpp"
+#include "app-utf8.hpp"
+
+
+namespace {
+
+    class Scanner {
+    public:
+
+        Scanner(std::string_view path, std::string_view text, app::CharCounts& counts):
+            m_path(path),
+            m_text(text),
+            m_counts(counts),
+            m_pos(0),
+            m_line(1) {
+        }
+
+        void scan_source();
+
+        void scan_po();
+
+        void scan_json();
+
+        void scan_text();
+
+    private:
+
+        [[nodiscard]]
+        bool at_end() const {
+            return m_pos >= m_text.size();
+        }
+
+        [[nodiscard]]
+        bool starts_with(std::string_view s) const {
+            return m_text.compare(m_pos, s.size(), s) == 0;
+        }
+
+        [[nodiscard]]
+        bool at_line_start() const;
+
+        [[nodiscard]]
+        bool follows_word(std::string_view word) const;
+
+        [[nodiscard]]
+        bool follows_literal_prefix() const;
+
+        void advance(size_t n = 1);
+
+        void skip_past(std::string_view end);
+
+        void skip_directive();
+
+        std::string read_quoted(char quote);
+
+        std::string read_raw();
+
+        void add_literal(const std::string& bytes, size_t line);
+
+        const std::string_view m_path;
+        const std::string_view m_text;
+        app::CharCounts& m_counts;
+        size_t m_pos;
+        size_t m_line;
+    };
+
+
+    void append_utf8(std::string& bytes, char32_t c) {
+        if ( c < 0x80 ) {
+            bytes += static_cast<char>(c);
+        } else if ( c < 0x800 ) {
+            bytes += static_cast<char>(0xC0 | (c >> 6));
+            bytes += static_cast<char>(0x80 | (c & 0x3F));
+        } else if ( c < 0x10000 ) {
+            bytes += static_cast<char>(0xE0 | (c >> 12));
+            bytes += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            bytes += static_cast<char>(0x80 | (c & 0x3F));
+        } else {
+            bytes += static_cast<char>(0xF0 | (c >> 18));
+            bytes += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+            bytes += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            bytes += static_cast<char>(0x80 | (c & 0x3F));
+        }
+    }
+
+
+    void Scanner::advance(size_t n) {
+        for (; n > 0 && !at_end(); n--) {
+            if ( m_text[m_pos] == '\n' ) {
+                m_line++;
+            }
+
+            m_pos++;
+        }
+    }
+
+
+    bool Scanner::at_line_start() const {
+        size_t pos = m_pos;
+
+        while (pos > 0 && (m_text[pos - 1] == ' ' || m_text[pos - 1] == '\t')) {
+            pos--;
+        }
+
+        return pos == 0 || m_text[pos - 1] == '\n';
+    }
+
+
+    bool Scanner::follows_word(std::string_view word) const {
+        auto is_identifier = [](char c) {
+            return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+        };
+
+        size_t end = m_text.find_last_not_of(" \t\r\n", (m_pos > 0) ? m_pos - 1 : 0);
+
+        if ( m_pos == 0 || end == std::string_view::npos || end + 1 < word.size() ) {
+            return false;
+        }
+
+        size_t start = end + 1 - word.size();
+
+        return m_text.compare(start, word.size(), word) == 0 && (start == 0 || !is_identifier(m_text[start - 1]));
+    }
+
+
+    bool Scanner::follows_literal_prefix() const {
+        auto is_identifier = [](char c) {
+            return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+        };
+
+        auto at_word_start = [&](size_t pos) {
+            return pos == 0 || !is_identifier(m_text[pos - 1]);
+        };
+
+        if ( at_word_start(m_pos) ) {
+            return true;
+        }
+
+        // L, u, U and u8 encoding prefixes, anything else (1'000, 0xFF'FF, ...) continues a word or number
+        char prev = m_text[m_pos - 1];
+
+        if ( prev == 'L' || prev == 'u' || prev == 'U' ) {
+            return at_word_start(m_pos - 1);
+        }
+
+        return prev == '8' && m_pos >= 2 && m_text[m_pos - 2] == 'u' && at_word_start(m_pos - 2);
+    }
+
+
+    void Scanner::skip_past(std::string_view end) {
+        while (!at_end() && !starts_with(end)) {
+            advance();
+        }
+
+        advance(end.size());
+    }
+
+
+    void Scanner::skip_directive() {
+        advance();
+
+        while (!at_end() && (m_text[m_pos] == ' ' || m_text[m_pos] == '\t')) {
+            advance();
+        }
+
+        // a macro's replacement text is ordinary code, whose literals are displayed wherever it's expanded
+        if ( starts_with("define") ) {
+            advance(6);
+            return;
+        }
+
+        // anything else (#include paths, #pragma, #error messages, ...) up to the end of the line, continuations
+        // included
+        while (!at_end() && m_text[m_pos] != '\n') {
+            if ( starts_with("\\\n") ) {
+                advance();
+            } else if ( starts_with("/*") ) {
+                skip_past("*/");
+                continue;
+            }
+
+            advance();
+        }
+    }
+
+
+    std::string Scanner::read_quoted(char quote) {
+        std::string bytes;
+
+        // opening quote
+        advance();
+
+        while (!at_end() && m_text[m_pos] != quote && m_text[m_pos] != '\n') {
+            char c = m_text[m_pos];
+
+            if ( c != '\\' ) {
+                bytes += c;
+                advance();
+                continue;
+            }
+
+            advance();
+
+            if ( at_end() ) {
+                break;
+            }
+
+            c = m_text[m_pos];
+            advance();
+
+            auto read_number = [&](int base, size_t max_digits) {
+                uint32_t value = 0;
+                size_t n = 0;
+
+                for (; n < max_digits && !at_end(); n++) {
+                    int digit = m_text[m_pos];
+
+                    if ( base == 8 && (digit < '0' || digit > '7') ) {
+                        break;
+                    } else if ( base == 16 && !std::isxdigit(digit) ) {
+                        break;
+                    }
+
+                    value = (value * base) + static_cast<uint32_t>(std::isdigit(digit) ? (digit - '0') :
+                                                                   (std::tolower(digit) - 'a' + 10));
+                    advance();
+                }
+
+                return value;
+            };
+
+            switch(c) {
+            case 'n': bytes += '\n'; break;
+            case 't': bytes += '\t'; break;
+            case 'r': bytes += '\r'; break;
+            case 'a': case 'b': case 'f': case 'v': bytes += '\0'; break;
+
+            case 'x':
+                // escaped bytes, which in UTF-8 literals may together form one multi-byte character; like the
+                // compiler, every hex digit belongs to the escape and the value is then narrowed to a byte
+                bytes += static_cast<char>(read_number(16, std::string_view::npos));
+                break;
+
+            case '0': case '1': case '2': case '3': case '4': case '5': case '6': case '7':
+                m_pos--;
+                bytes += static_cast<char>(read_number(8, 3));
+                break;
+
+            case 'u':
+            case 'U': {
+                auto c32 = static_cast<char32_t>(read_number(16, (c == 'u') ? 4 : 8));
+
+                // JSON spells characters outside the BMP as a pair of UTF-16 surrogates
+                if ( c32 >= 0xD800 && c32 < 0xDC00 && starts_with("\\u") ) {
+                    advance(2);
+                    c32 = 0x10000 + ((c32 - 0xD800) << 10) + (read_number(16, 4) - 0xDC00);
+                }
+
+                append_utf8(bytes, c32);
+                break;
+            }
+
+            default:
+                // \\, \", \', \? and JSON's \/ stand for themselves
+                bytes += c;
+                break;
+            }
+        }
+
+        // closing quote
+        advance();
+
+        return bytes;
+    }
+
+
+    std::string Scanner::read_raw() {
+        // R"delimiter( ... )delimiter"
+        size_t open = m_text.find('(', m_pos);
+
+        if ( open == std::string_view::npos ) {
+            advance(m_text.size());
+            return std::string();
+        }
+
+        std::string end = ")" + std::string(m_text.substr(m_pos + 1, open - m_pos - 1)) + "\"";
+        size_t close = m_text.find(end, open);
+
+        if ( close == std::string_view::npos ) {
+            close = m_text.size();
+        }
+
+        std::string bytes(m_text.substr(open + 1, close - open - 1));
+
+        advance(close + end.size() - m_pos);
+
+        return bytes;
+    }
+
+
+    void Scanner::add_literal(const std::string& bytes, size_t line) {
+        try {
+            for (auto c: app::utf8_decode(bytes)) {
+                if ( c >= 32 ) {
+                    m_counts[c]++;
+                }
+            }
+        } catch (app::Error& e) {
+            throw app::Error("{}:{}: {}", m_path, line, e.what());
+        }
+    }
+
+
+    void Scanner::scan_source() {
+        while (!at_end()) {
+            char c = m_text[m_pos];
+
+            if ( starts_with("//") ) {
+                skip_past("\n");
+            } else if ( starts_with("/*") ) {
+                skip_past("*/");
+            } else if ( c == '#' && at_line_start() ) {
+                skip_directive();
+            } else if ( c == 'R' && starts_with("R\"") && follows_literal_prefix() ) {
+                size_t line = m_line;
+
+                advance();
+                add_literal(read_raw(), line);
+            } else if ( c == '"' ) {
+                size_t line = m_line;
+                bool linkage = follows_word("extern");
+                std::string bytes = read_quoted('"');
+
+                // the "C" of extern "C" names a language rather than text
+                if ( !linkage ) {
+                    add_literal(bytes, line);
+                }
+            } else if ( c == '\'' && follows_literal_prefix() ) {
+                // character literals are skipped, but must be parsed so that '"' doesn't start a string (a quote
+                // within a number is a digit separator)
+                read_quoted('\'');
+            } else {
+                advance();
+            }
+        }
+    }
+
+
+    void Scanner::scan_po() {
+        bool displayed = true;
+        bool in_msgid = false;
+        std::string msgid;
+
+        // msgid, msgstr and their continuation lines carry text (untranslated msgids are shown as is), msgctxt doesn't,
+        // and neither does the msgstr of the header entry, whose empty msgid files catalog metadata under it
+        while (!at_end()) {
+            char c = m_text[m_pos];
+
+            if ( c == '#' ) {
+                skip_past("\n");
+            } else if ( c == '"' ) {
+                size_t line = m_line;
+                std::string bytes = read_quoted('"');
+
+                if ( in_msgid ) {
+                    msgid += bytes;
+                }
+
+                if ( displayed ) {
+                    add_literal(bytes, line);
+                }
+            } else if ( starts_with("msgctxt") ) {
+                displayed = false;
+                in_msgid = false;
+                advance(7);
+            } else if ( starts_with("msgid") ) {
+                // msgid_plural belongs to the same entry as the msgid before it
+                if ( !starts_with("msgid_plural") ) {
+                    msgid.clear();
+                }
+
+                displayed = true;
+                in_msgid = true;
+                advance(5);
+            } else if ( starts_with("msgstr") ) {
+                displayed = !msgid.empty();
+                in_msgid = false;
+                advance(6);
+            } else {
+                advance();
+            }
+        }
+    }
+
+
+    void Scanner::scan_json() {
+        while (!at_end()) {
+            if ( m_text[m_pos] != '"' ) {
+                advance();
+                continue;
+            }
+
+            size_t line = m_line;
+            std::string bytes = read_quoted('"');
+            size_t next = m_text.find_first_not_of(" \t\r\n", m_pos);
+
+            // keys are identifiers rather than displayed text
+            if ( next == std::string_view::npos || m_text[next] != ':' ) {
+                add_literal(bytes, line);
+            }
+        }
+    }
+
+
+    void Scanner::scan_text() {
+        while (!at_end()) {
+            size_t end = std::min(m_text.find('\n', m_pos), m_text.size());
+
+            add_literal(std::string(m_text.substr(m_pos, end - m_pos)), m_line);
+            advance(std::min(end + 1, m_text.size()) - m_pos);
+        }
+    }
+
+}
+
+
+void app::corpus_scan(std::string_view path, app::CharSet& char_set) {
+    app::CharCounts counts;
+
+    corpus_count(path, counts);
+
+    for (const auto& count: counts) {
+        char_set.insert(count.first);
+    }
+}
+
+
+void app::corpus_count(std::string_view path, app::CharCounts& counts) {
+    app::MappedFile file(path);
+    std::string extension = std::filesystem::path(path).extension().string();
+    Scanner scanner(path, file.text(), counts);
+
+    if ( extension == ".po" || extension == ".pot" ) {
+        scanner.scan_po();
+    } else if ( extension == ".json" ) {
+        scanner.scan_json();
+    } else if ( extension == ".txt" ) {
+        scanner.scan_text();
+    } else {
+        scanner.scan_source();
+    }
+}
@@ -0,0 +1,33 @@
+/*
+ * font2c - Command-line utility for converting font glyphs into bitmap images
+ * embeddable in C source code.
+ *
+ * https://github.com/mattbucknall/font2c
+ *
+ * Copyright (C) 2022 Matthew T. Bucknall
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include <string_view>
+
+#include "app-char-set.hpp"
+#include "app-error.hpp"
+
+
+namespace app {
+    void corpus_scan(std::string_view path, app::CharSet& char_set);
+
+    void corpus_count(std::string_view path, app::CharCounts& counts);
+}
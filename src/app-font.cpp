@@ -18,6 +18,15 @@
  * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+#include <algorithm>
+#include <cmath>
+
+extern "C" {
+#include <ft2build.h>
+#include FT_TRUETYPE_TABLES_H
+#include FT_TRUETYPE_TAGS_H
+}
+
 #include "app-font.hpp"
 #include "app-ft-lib.hpp"
 
@@ -51,3 +60,97 @@ Font::~Font() noexcept {
 Font::operator FT_Face&() {
     return m_face;
 }
+
+
+unsigned int Font::char_index(char32_t codepoint) const noexcept {
+    return FT_Get_Char_Index(m_face, codepoint);
+}
+
+
+app::CharSet Font::coverage() const {
+    app::CharSet coverage;
+    FT_UInt index;
+    FT_ULong codepoint = FT_Get_First_Char(m_face, &index);
+
+    // walks the cmap in ascending codepoint order, so every insert extends the last range
+    while ( index != 0 ) {
+        coverage.insert(static_cast<char32_t>(codepoint));
+        codepoint = FT_Get_Next_Char(m_face, codepoint, &index);
+    }
+
+    return coverage;
+}
+
+
+bool Font::has_kerning() const noexcept {
+    return FT_HAS_KERNING(m_face);
+}
+
+
+int Font::kerning(unsigned int left_index, unsigned int right_index) const {
+    FT_Vector delta;
+    FT_Error err = FT_Get_Kerning(m_face, left_index, right_index, FT_KERNING_DEFAULT, &delta);
+
+    if ( err ) {
+        throw app::Error("Unable to get kerning for glyph pair {}, {}", left_index, right_index);
+    }
+
+    return static_cast<int>(std::lround(static_cast<double>(delta.x) / 64.0));
+}
+
+
+std::optional<std::vector<std::pair<unsigned int, unsigned int>>> Font::kerning_pairs() const {
+    std::vector<std::pair<unsigned int, unsigned int>> pairs;
+    std::vector<FT_Byte> table;
+    FT_ULong size = 0;
+
+    // kerning of fonts without an sfnt kern table (e.g. Type 1 fonts with AFM metrics) can only be probed pair by pair
+    if ( !FT_IS_SFNT(m_face) || FT_Load_Sfnt_Table(m_face, TTAG_kern, 0, nullptr, &size) != 0 ) {
+        return std::nullopt;
+    }
+
+    table.resize(size);
+
+    if ( FT_Load_Sfnt_Table(m_face, TTAG_kern, 0, table.data(), &size) != 0 ) {
+        return std::nullopt;
+    }
+
+    auto u16 = [&](size_t pos) {
+        return (pos + 2 <= table.size()) ? ((static_cast<unsigned int>(table[pos]) << 8) | table[pos + 1]) : 0u;
+    };
+
+    // FT_Get_Kerning only reads the horizontal format 0 subtables of version 0 tables, walked here the way FreeType
+    // walks them, broken lengths and pair counts included
+    if ( table.size() < 4 || u16(0) != 0 ) {
+        return pairs;
+    }
+
+    size_t n_tables = u16(2);
+    size_t pos = 4;
+
+    for (size_t i = 0; i < n_tables && pos + 6 <= table.size(); i++) {
+        size_t length = u16(pos + 2);
+        unsigned int coverage = u16(pos + 4);
+        size_t next = std::min(pos + length, table.size());
+
+        if ( length <= 6 + 8 ) {
+            break;
+        }
+
+        if ( (coverage & 3) == 1 && (coverage >> 8) == 0 && pos + 6 + 8 <= next ) {
+            size_t first = pos + 6 + 8;
+            size_t n_pairs = std::min<size_t>(u16(pos + 6), (next - first) / 6);
+
+            for (size_t j = 0; j < n_pairs; j++) {
+                pairs.emplace_back(u16(first + (j * 6)), u16(first + (j * 6) + 2));
+            }
+        }
+
+        pos = next;
+    }
+
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+    return pairs;
+}
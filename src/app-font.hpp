@@ -20,13 +20,17 @@
 
 #pragma once
 
+#include <optional>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 extern "C" {
 #include <ft2build.h>
 #include FT_FREETYPE_H
 }
 
+#include "app-char-set.hpp"
 #include "app-error.hpp"
 #include "app-ft-lib.hpp"
 
@@ -46,6 +50,21 @@ namespace app {
 
         operator FT_Face&(); // NOLINT(google-explicit-constructor)
 
+        [[nodiscard]]
+        unsigned int char_index(char32_t codepoint) const noexcept;
+
+        [[nodiscard]]
+        app::CharSet coverage() const;
+
+        [[nodiscard]]
+        bool has_kerning() const noexcept;
+
+        [[nodiscard]]
+        int kerning(unsigned int left_index, unsigned int right_index) const;
+
+        [[nodiscard]]
+        std::optional<std::vector<std::pair<unsigned int, unsigned int>>> kerning_pairs() const;
+
     private:
 
         app::FtLib m_lib;
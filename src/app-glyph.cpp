@@ -18,6 +18,8 @@
  * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+#include <algorithm>
+
 #include "app-glyph.hpp"
 
 using namespace app;
@@ -28,12 +30,15 @@ GlyphError::~GlyphError() noexcept = default;
 
 Glyph::Glyph(Font& font, char32_t codepoint, bool anti_aliased, bool no_hinting):
     m_codepoint(codepoint),
-    m_lib(app::FtLib::singleton()) {
+    m_width(0),
+    m_height(0) {
+    app::FtLib& lib = app::FtLib::singleton();
     FT_Error err;
     FT_Int32 load_flags;
     FT_Render_Mode render_mode;
     unsigned int index;
     FT_GlyphSlot glyph;
+    FT_Bitmap bitmap;
 
     try {
         load_flags = FT_LOAD_RENDER;
@@ -69,30 +74,45 @@ Glyph::Glyph(Font& font, char32_t codepoint, bool anti_aliased, bool no_hinting)
             throw app::GlyphError("Unable to render glyph for this codepoint");
         }
 
-        FT_Bitmap_Init(&m_bitmap);
-        err = FT_Bitmap_Convert(m_lib, &glyph->bitmap, &m_bitmap, 1);
+        m_pixels.resize(glyph->bitmap.width * glyph->bitmap.rows);
+
+        FT_Bitmap_Init(&bitmap);
+        err = FT_Bitmap_Convert(lib, &glyph->bitmap, &bitmap, 1);
 
         if ( err ) {
+            FT_Bitmap_Done(lib, &bitmap);
             throw app::GlyphError("Unable to normalize pixel depth for this codepoint");
         }
 
-        if ( render_mode == FT_RENDER_MODE_MONO ) {
-            uint8_t* row_i = m_bitmap.buffer;
-            uint8_t* row_e = row_i + (m_bitmap.pitch * m_bitmap.rows);
+        m_width = static_cast<int>(bitmap.width);
+        m_height = static_cast<int>(bitmap.rows);
+
+        const uint8_t* src_row_i = bitmap.buffer;
+        uint8_t* row_i = m_pixels.data();
+        uint8_t* row_e = row_i + (m_width * m_height);
 
-            while(row_i < row_e) {
-                uint8_t* pixel_i = row_i;
-                uint8_t* pixel_e = pixel_i + m_bitmap.width;
+        while(row_i < row_e) {
+            const uint8_t* src_pixel_i = src_row_i;
+            uint8_t* pixel_i = row_i;
+            uint8_t* pixel_e = pixel_i + m_width;
 
-                while(pixel_i < pixel_e) {
-                    *pixel_i = (*pixel_i > 0) ? 0xFF : 0x00;
-                    pixel_i++;
+            while(pixel_i < pixel_e) {
+                if ( render_mode == FT_RENDER_MODE_MONO ) {
+                    *pixel_i = (*src_pixel_i > 0) ? 0xFF : 0x00;
+                } else {
+                    *pixel_i = *src_pixel_i;
                 }
 
-                row_i += m_bitmap.pitch;
+                pixel_i++;
+                src_pixel_i++;
             }
+
+            src_row_i += bitmap.pitch;
+            row_i += m_width;
         }
 
+        FT_Bitmap_Done(lib, &bitmap);
+
         m_x_bearing = static_cast<int>(glyph->bitmap_left);
         m_y_bearing = static_cast<int>(glyph->bitmap_top - 1);
         m_x_advance = static_cast<int>((glyph->advance.x + 32) / 64);
@@ -104,11 +124,20 @@ Glyph::Glyph(Font& font, char32_t codepoint, bool anti_aliased, bool no_hinting)
 }
 
 
-Glyph::~Glyph() noexcept {
-    FT_Bitmap_Done(m_lib, &m_bitmap);
+Glyph::Glyph() noexcept:
+    m_codepoint(0),
+    m_x_bearing(0),
+    m_y_bearing(0),
+    m_x_advance(0),
+    m_y_advance(0),
+    m_width(0),
+    m_height(0) {
 }
 
 
+Glyph::~Glyph() noexcept = default;
+
+
 char32_t Glyph::codepoint() const noexcept {
     return m_codepoint;
 }
@@ -135,20 +164,90 @@ int Glyph::y_advance() const noexcept {
 
 
 int Glyph::width() const noexcept {
-    return static_cast<int>(m_bitmap.width);
+    return m_width;
 }
 
 
 int Glyph::height() const noexcept {
-    return static_cast<int>(m_bitmap.rows);
+    return m_height;
 }
 
 
 const uint8_t* Glyph::buffer() const noexcept {
-    return m_bitmap.buffer;
+    return m_pixels.data();
+}
+
+
+uint8_t* Glyph::buffer() noexcept {
+    return m_pixels.data();
 }
 
 
 int Glyph::pitch() const noexcept {
-    return m_bitmap.pitch;
+    return m_width;
+}
+
+
+app::Rectangle Glyph::bounds() const noexcept {
+    return {m_x_bearing, -m_y_bearing, m_width, m_height};
+}
+
+
+void Glyph::pad(const app::Rectangle& box) {
+    app::Rectangle r = bounds();
+
+    if ( !r.empty() && (r.x1 < box.x1 || r.y1 < box.y1 || r.x2 > box.x2 || r.y2 > box.y2) ) {
+        throw app::GlyphError("Codepoint U+{:04X}: Glyph does not fit within padded box",
+                              static_cast<uint32_t>(m_codepoint));
+    }
+
+    std::vector<uint8_t> pixels(box.width() * box.height());
+
+    if ( !r.empty() ) {
+        const uint8_t* src_row_i = m_pixels.data();
+        uint8_t* row_i = pixels.data() + ((r.y1 - box.y1) * box.width()) + (r.x1 - box.x1);
+
+        for (int y = 0; y < m_height; y++) {
+            std::copy(src_row_i, src_row_i + m_width, row_i);
+            src_row_i += m_width;
+            row_i += box.width();
+        }
+    }
+
+    m_pixels = std::move(pixels);
+    m_x_bearing = box.x1;
+    m_y_bearing = -box.y1;
+    m_width = box.width();
+    m_height = box.height();
+}
+
+
+Glyph Glyph::crop(const app::Rectangle& box) const {
+    app::Rectangle r = bounds();
+    Glyph glyph;
+
+    glyph.m_codepoint = m_codepoint;
+    glyph.m_x_bearing = box.x1;
+    glyph.m_y_bearing = -box.y1;
+    glyph.m_x_advance = m_x_advance;
+    glyph.m_y_advance = m_y_advance;
+    glyph.m_width = box.width();
+    glyph.m_height = box.height();
+    glyph.m_pixels.resize(box.width() * box.height());
+
+    for (int y = box.y1; y < box.y2; y++) {
+        for (int x = box.x1; x < box.x2; x++) {
+            if ( r.contains(x, y) ) {
+                glyph.m_pixels[((y - box.y1) * box.width()) + (x - box.x1)] =
+                        m_pixels[((y - r.y1) * m_width) + (x - r.x1)];
+            }
+        }
+    }
+
+    return glyph;
+}
+
+
+void Glyph::set_x_advance(int x_advance) noexcept {
+    m_x_advance = x_advance;
 }
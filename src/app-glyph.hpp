@@ -26,9 +26,13 @@ extern "C" {
 #include FT_BITMAP_H
 }
 
+#include <cstdint>
+#include <vector>
+
 #include "app-error.hpp"
 #include "app-font.hpp"
 #include "app-ft-lib.hpp"
+#include "app-rectangle.hpp"
 
 
 namespace app {
@@ -48,10 +52,14 @@ public:
 
         Glyph(const Glyph&) = delete;
 
+        Glyph(Glyph&&) noexcept = default;
+
         ~Glyph() noexcept;
 
         Glyph& operator= (const Glyph&) = delete;
 
+        Glyph& operator= (Glyph&&) noexcept = default;
+
         [[nodiscard]]
         char32_t codepoint() const noexcept;
 
@@ -76,18 +84,34 @@ public:
         [[nodiscard]]
         const uint8_t* buffer() const noexcept;
 
+        [[nodiscard]]
+        uint8_t* buffer() noexcept;
+
         [[nodiscard]]
         int pitch() const noexcept;
 
+        [[nodiscard]]
+        app::Rectangle bounds() const noexcept;
+
+        void pad(const app::Rectangle& box);
+
+        [[nodiscard]]
+        Glyph crop(const app::Rectangle& box) const;
+
+        void set_x_advance(int x_advance) noexcept;
+
     private:
 
+        Glyph() noexcept;
+
         char32_t m_codepoint;
         int m_x_bearing;
         int m_y_bearing;
         int m_x_advance;
         int m_y_advance;
-        app::FtLib m_lib;
-        FT_Bitmap m_bitmap;
+        int m_width;
+        int m_height;
+        std::vector<uint8_t> m_pixels;
     };
 
 }
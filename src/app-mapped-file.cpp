@@ -0,0 +1,93 @@
+/*
+ * font2c - Command-line utility for converting font glyphs into bitmap images
+ * embeddable in C source code.
+ *
+ * https://github.com/mattbucknall/font2c
+ *
+ * Copyright (C) 2022 Matthew T. Bucknall
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <fstream>
+#include <iterator>
+
+#if __has_include(<sys/mman.h>)
+#define APP_HAVE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "app-mapped-file.hpp"
+
+using namespace app;
+
+
+MappedFile::MappedFile(std::string_view path):
+    m_data(nullptr),
+    m_size(0),
+    m_buffer() {
+    std::string path_str(path);
+
+#ifdef APP_HAVE_MMAP
+    int fd = open(path_str.c_str(), O_RDONLY);
+
+    if ( fd >= 0 ) {
+        struct stat st = {};
+
+        if ( fstat(fd, &st) == 0 && S_ISREG(st.st_mode) ) {
+            // empty files cannot be mapped, but need no data either
+            if ( st.st_size == 0 ) {
+                close(fd);
+                return;
+            }
+
+            void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if ( data != MAP_FAILED ) {
+                m_data = static_cast<const char*>(data);
+                m_size = static_cast<size_t>(st.st_size);
+            }
+        }
+
+        close(fd);
+
+        if ( m_data ) {
+            return;
+        }
+    }
+#endif
+
+    // pipes and platforms without mmap are read into memory instead
+    std::ifstream ifs(path_str, std::ios::binary);
+
+    if ( !ifs ) {
+        throw app::Error("Unable to open file '{}'", path);
+    }
+
+    m_buffer.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+}
+
+
+MappedFile::~MappedFile() {
+#ifdef APP_HAVE_MMAP
+    if ( m_data ) {
+        munmap(const_cast<char*>(m_data), m_size);
+    }
+#endif
+}
+
+
+std::string_view MappedFile::text() const {
+    return m_data ? std::string_view(m_data, m_size) : std::string_view(m_buffer);
+}
@@ -33,5 +33,35 @@ Options::Options():
         antialiasing(true),
         no_hinting(false),
         preview_path(),
-        center_adjust(0) {
+        center_adjust(0),
+        monospace(false),
+        kerning(false),
+        external_path(),
+        reference_text(),
+        read_gap(16),
+        section(),
+        hot_section(),
+        hot_char_set_path(),
+        align(0),
+        row_align(1),
+        glyph_align(1),
+        word_output(),
+        bitstream(false),
+        tile_size(),
+        color_format(),
+        color_endian("le"),
+        fg_color(),
+        bg_color(),
+        palette(),
+        gamma(1.0),
+        planar(false),
+        auto_depth(-1),
+        dither(false),
+        optimal_levels(false),
+        variants(),
+        corpus_paths(),
+        include_ranges(),
+        locales(),
+        frequency_paths(),
+        cache_line(32) {
 }
@@ -21,6 +21,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 
 namespace app {
@@ -36,6 +37,36 @@ namespace app {
         bool no_hinting;
         std::string preview_path;
         int center_adjust;
+        bool monospace;
+        bool kerning;
+        std::string external_path;
+        std::string reference_text;
+        int read_gap;
+        std::string section;
+        std::string hot_section;
+        std::string hot_char_set_path;
+        int align;
+        int row_align;
+        int glyph_align;
+        std::string word_output;
+        bool bitstream;
+        std::string tile_size;
+        std::string color_format;
+        std::string color_endian;
+        std::string fg_color;
+        std::string bg_color;
+        std::string palette;
+        double gamma;
+        bool planar;
+        int auto_depth;
+        bool dither;
+        bool optimal_levels;
+        std::vector<std::string> variants;
+        std::vector<std::string> corpus_paths;
+        std::string include_ranges;
+        std::vector<std::string> locales;
+        std::vector<std::string> frequency_paths;
+        int cache_line;
 
         Options();
     };
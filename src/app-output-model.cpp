@@ -18,12 +18,17 @@
  * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+#include <algorithm>
 #include <cassert>
+#include <cctype>
 #include <cerrno>
+#include <cmath>
 #include <cstdio>
 #include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <numeric>
+#include <set>
 #include <utility>
 
 #include <fmt/format.h>
@@ -37,23 +42,40 @@ using namespace app;
 OutputModel::OutputModel(int depth, bool msb_first, RasterizerFunc rasterizer_func, std::string_view cmd_line):
     m_rasterizer_func(std::move(rasterizer_func)),
     m_cmd_line(cmd_line),
+    m_depth(depth),
+    m_msb_first(msb_first),
     m_line_ascent(0),
     m_line_descent(0),
     m_line_height(0),
-    m_current_byte(0) {
-    assert(depth == 1 || depth == 2 || depth == 4 || depth == 8);
+    m_bit_pos(0),
+    m_bitstream(false),
+    m_row_align(1),
+    m_glyph_align(1),
+    m_hot_size(0),
+    m_line_base(0),
+    m_tile_width(0),
+    m_tile_height(0),
+    m_tile_size(0),
+    m_big_endian(false),
+    m_planar(false),
+    m_glyph_depth(depth),
+    m_dither(false),
+    m_codes(app::quantize_table(std::min(depth, 8))),
+    m_squared_error(0.0),
+    m_blurred_error(0.0),
+    m_n_pixels(0) {
+    assert((depth >= 1 && depth <= 8) || depth == 16 || depth == 24 || depth == 32);
+}
 
-    m_shift = 8 - depth;
 
-    if ( msb_first ) {
-        m_start = depth - 1;
-        m_delta = -depth;
-    } else {
-        m_start = 0;
-        m_delta = depth;
-    };
+int OutputModel::depth() const {
+    return m_depth;
+}
 
-    m_bit_pos = m_start;
+
+int OutputModel::page_height() const {
+    // each bit-plane of a planar font is a 1bpp image with its own 8 pixel pages
+    return 8 / (m_planar ? 1 : m_glyph_depth);
 }
 
 
@@ -88,19 +110,263 @@ const std::vector<uint8_t>& OutputModel::pixel_data() const {
 }
 
 
-void OutputModel::add_glyph(const app::Glyph& glyph) {
+bool OutputModel::is_monospace() const {
+    if ( m_glyphs.empty() ) {
+        return false;
+    }
+
+    const auto& first = m_glyphs.front();
+    uint32_t glyph_size = glyph_stride();
+
+    for (size_t i = 0; i < m_glyphs.size(); i++) {
+        const auto& glyph = m_glyphs[i];
+
+        if ( glyph.x_bearing != first.x_bearing || glyph.y_bearing != first.y_bearing ||
+             glyph.width != first.width || glyph.height != first.height || glyph.x_advance != first.x_advance ||
+             glyph.offset != (i * glyph_size) || m_glyph_sizes[i] > glyph_size ||
+             glyph.depth != 0 ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+size_t OutputModel::memory_size(bool external) const {
+    size_t total_size = external ? 0 : m_pixel_data.size();
+
+    if ( is_monospace() ) {
+        total_size += mono_ranges().size() * sizeof(font2c_range_t);
+    } else {
+        total_size += m_glyphs.size() * sizeof(font2c_glyph_t);
+    }
+
+    total_size += m_kerning.size() * sizeof(font2c_kerning_t);
+    total_size += m_tile_map.size() * sizeof(uint16_t);
+    total_size += m_levels.size();
+
+    return total_size;
+}
+
+
+std::vector<font2c_range_t> OutputModel::mono_ranges() const {
+    std::vector<font2c_range_t> ranges;
+
+    for (size_t i = 0; i < m_glyphs.size(); i++) {
+        uint32_t codepoint = m_glyphs[i].codepoint;
+
+        if ( !ranges.empty() && (ranges.back().first + ranges.back().count) == codepoint ) {
+            ranges.back().count++;
+        } else {
+            ranges.push_back({codepoint, 1, static_cast<uint32_t>(i)});
+        }
+    }
+
+    return ranges;
+}
+
+
+double OutputModel::psnr(bool blurred) const {
+    return app::quantize_psnr(blurred ? m_blurred_error : m_squared_error, m_n_pixels);
+}
+
+
+OutputModel::ReadCount OutputModel::count_reads(std::u32string_view text, uint32_t max_gap) const {
+    std::vector<std::pair<uint32_t, uint32_t>> extents;
+    ReadCount count = {0, 0};
+
+    for (auto codepoint: text) {
+        auto i = std::lower_bound(m_glyphs.begin(), m_glyphs.end(), codepoint,
+                                  [](const font2c_glyph_t& glyph, char32_t c) { return glyph.codepoint < c; });
+
+        if ( i != m_glyphs.end() && i->codepoint == codepoint ) {
+            uint32_t size = glyph_size(i - m_glyphs.begin());
+
+            if ( size > 0 ) {
+                extents.emplace_back(i->offset, i->offset + size);
+            }
+        }
+    }
+
+    count.uncoalesced = extents.size();
+    std::sort(extents.begin(), extents.end());
+
+    // mirrors font2c_run_fetch(): extents separated by no more than max_gap bytes share a single read
+    for (size_t i = 0; i < extents.size();) {
+        uint32_t end = extents[i].second;
+
+        for (i++; i < extents.size() && extents[i].first <= end + max_gap; i++) {
+            end = std::max(end, extents[i].second);
+        }
+
+        count.coalesced++;
+    }
+
+    return count;
+}
+
+
+OutputModel::Footprint OutputModel::cache_footprint(const app::CharCounts& counts, uint32_t line_size) const {
+    std::vector<std::pair<uint64_t, size_t>> used;
+    std::set<uint32_t> lines;
+    Footprint footprint = {0, 0};
+    uint64_t total = 0;
+    uint64_t covered = 0;
+
+    for (size_t i = 0; i < m_glyphs.size(); i++) {
+        auto count = counts.find(m_glyphs[i].codepoint);
+
+        if ( count != counts.end() && glyph_size(i) > 0 ) {
+            used.emplace_back(count->second, i);
+            total += count->second;
+        }
+    }
+
+    std::stable_sort(used.begin(), used.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    // hot lines are those holding the most frequent glyphs that together make up 90% of the corpus text
+    for (const auto& [count, index]: used) {
+        uint32_t offset = m_glyphs[index].offset;
+
+        for (uint32_t line = offset / line_size; line <= (offset + glyph_size(index) - 1) / line_size; line++) {
+            lines.insert(line);
+        }
+
+        if ( covered * 10 < total * 9 ) {
+            footprint.hot_lines = lines.size();
+        }
+
+        covered += count;
+    }
+
+    footprint.lines = lines.size();
+
+    return footprint;
+}
+
+
+void OutputModel::set_alignment(int row_align, int glyph_align) {
+    assert(m_glyphs.empty());
+    assert(row_align == 1 || row_align == 2 || row_align == 4 || row_align == 8);
+    assert(glyph_align > 0 && (glyph_align & (glyph_align - 1)) == 0);
+
+    m_row_align = row_align;
+
+    // rows are padded relative to glyph start, so glyphs must be at least row aligned for rows to be aligned
+    m_glyph_align = std::max(row_align, glyph_align);
+}
+
+
+void OutputModel::set_bitstream(bool bitstream) {
+    assert(m_glyphs.empty());
+
+    m_bitstream = bitstream;
+}
+
+
+void OutputModel::set_tiles(int width, int height) {
+    assert(m_glyphs.empty());
+    assert(width > 0 && height > 0);
+
+    m_tile_width = width;
+    m_tile_height = height;
+}
+
+
+void OutputModel::set_palette(std::vector<uint32_t> palette, bool big_endian) {
+    assert(m_glyphs.empty());
+    assert(palette.size() >= 2 && m_depth >= 16);
+
+    m_palette = std::move(palette);
+    m_big_endian = big_endian;
+}
+
+
+void OutputModel::set_planar(bool planar) {
+    assert(m_glyphs.empty());
+    assert(!planar || (m_depth <= 8 && !m_bitstream));
+
+    m_planar = planar;
+}
+
+
+void OutputModel::set_quantization(std::vector<uint8_t> levels, bool dither) {
+    assert(m_glyphs.empty() && m_palette.empty());
+    assert(levels.empty() || levels.size() == (1u << m_depth));
+
+    m_levels = std::move(levels);
+    m_dither = dither;
+}
+
+
+void OutputModel::set_fallback(std::string_view symbol) {
+    m_fallback = symbol;
+}
+
+
+void OutputModel::set_line_metrics(int ascent, int descent, int height) {
+    // shards drawn together must agree on line metrics, so each takes the largest of them all
+    m_line_ascent = std::max(m_line_ascent, ascent);
+    m_line_descent = std::max(m_line_descent, descent);
+    m_line_height = std::max(m_line_height, height);
+}
+
+
+void OutputModel::add_glyph(const app::Glyph& glyph, int depth) {
+    assert(depth == 0 || (depth >= 1 && depth <= 8 && m_palette.empty() && !m_tile_width));
+
+    std::optional<app::Glyph> dithered;
+
+    if ( !m_tile_width ) {
+        align_pixels(0, m_glyph_align);
+    }
+
+    m_glyph_depth = depth ? depth : m_depth;
+
+    if ( m_palette.empty() ) {
+        // glyphs stored at a depth other than the font's always use evenly spaced levels
+        std::vector<uint8_t> levels = (m_levels.empty() || m_glyph_depth != m_depth) ?
+                app::quantize_levels(m_glyph_depth) : m_levels;
+
+        if ( m_dither || !m_levels.empty() ) {
+            m_codes = app::quantize_table(levels);
+        } else {
+            m_codes = app::quantize_table(m_glyph_depth);
+        }
+
+        if ( m_dither ) {
+            // diffuse over the whole glyph before it is split into tiles, so tile edges don't show
+            dithered.emplace(glyph.crop(glyph.bounds()));
+            app::quantize_dither(dithered->buffer(), dithered->width(), dithered->height(), dithered->pitch(),
+                                 levels, m_codes);
+        }
+
+        measure_error(glyph, dithered ? *dithered : glyph, levels);
+    }
+
+    const app::Glyph& source = dithered ? *dithered : glyph;
+
     font2c_glyph_t f2c_glyph = {
             .codepoint = glyph.codepoint(),
-            .offset = static_cast<uint32_t>(m_pixel_data.size()),
+            .offset = current_offset(),
             .x_bearing = static_cast<int16_t>(glyph.x_bearing()),
             .y_bearing = static_cast<int16_t>(glyph.y_bearing()),
             .width = static_cast<uint16_t>(glyph.width()),
             .height = static_cast<uint16_t>(glyph.height()),
-            .x_advance = static_cast<int16_t>(glyph.x_advance())
+            .x_advance = static_cast<int16_t>(glyph.x_advance()),
+            .depth = static_cast<uint8_t>((m_glyph_depth != m_depth) ? m_glyph_depth : 0)
     };
 
     m_glyphs.push_back(f2c_glyph);
-    m_rasterizer_func(*this, glyph);
+
+    if ( m_tile_width ) {
+        add_tiles(source);
+    } else {
+        rasterize(source);
+    }
+
+    m_glyph_sizes.push_back(current_offset() - f2c_glyph.offset);
 
     m_line_ascent = std::max(m_line_ascent, static_cast<int>(f2c_glyph.y_bearing));
     m_line_descent = std::max(m_line_descent, f2c_glyph.height - f2c_glyph.y_bearing);
@@ -108,25 +374,414 @@ void OutputModel::add_glyph(const app::Glyph& glyph) {
 }
 
 
+void OutputModel::measure_error(const app::Glyph& glyph, const app::Glyph& quantized,
+                                const std::vector<uint8_t>& levels) {
+    int width = glyph.width();
+    int height = glyph.height();
+    std::vector<double> errors(static_cast<size_t>(width) * static_cast<size_t>(height));
+
+    for (int y = 0; y < height; y++) {
+        const uint8_t* source = glyph.buffer() + (y * glyph.pitch());
+        const uint8_t* result = quantized.buffer() + (y * quantized.pitch());
+
+        for (int x = 0; x < width; x++) {
+            double error = static_cast<double>(source[x]) - levels[m_codes[result[x]]];
+
+            errors[(y * width) + x] = error;
+            m_squared_error += error * error;
+        }
+    }
+
+    // dithering trades per-pixel error for correct average coverage, which is what the eye sees, so also measure
+    // the error left after a 3x3 box blur
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            double error = 0.0;
+
+            for (int ny = std::max(y - 1, 0); ny <= std::min(y + 1, height - 1); ny++) {
+                for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, width - 1); nx++) {
+                    error += errors[(ny * width) + nx];
+                }
+            }
+
+            m_blurred_error += (error / 9.0) * (error / 9.0);
+        }
+    }
+
+    m_n_pixels += static_cast<uint64_t>(width) * static_cast<uint64_t>(height);
+}
+
+
+void OutputModel::rasterize(const app::Glyph& glyph) {
+    m_line_base = m_pixel_data.size();
+    m_rasterizer_func(*this, glyph);
+
+    if ( !m_planar ) {
+        return;
+    }
+
+    // write buffered pixels out one bit-plane at a time, least-significant plane first, lines padded as for 1bpp
+    for (int plane = 0; plane < m_glyph_depth; plane++) {
+        size_t start = 0;
+
+        for (size_t end: m_plane_lines) {
+            for (size_t i = start; i < end; i++) {
+                write_bits((m_plane_values[i] >> plane) & 1, 1);
+            }
+
+            m_bit_pos = 0;
+            align_pixels(m_line_base, m_row_align);
+            start = end;
+        }
+    }
+
+    m_plane_values.clear();
+    m_plane_lines.clear();
+}
+
+
+void OutputModel::add_tiles(const app::Glyph& glyph) {
+    app::Rectangle box = glyph.bounds();
+
+    assert((box.width() % m_tile_width) == 0 && (box.height() % m_tile_height) == 0);
+
+    for (int y = box.y1; y < box.y2; y += m_tile_height) {
+        for (int x = box.x1; x < box.x2; x += m_tile_width) {
+            size_t start = m_pixel_data.size();
+
+            rasterize(glyph.crop({x, y, m_tile_width, m_tile_height}));
+
+            std::vector<uint8_t> tile(m_pixel_data.begin() + static_cast<ptrdiff_t>(start), m_pixel_data.end());
+            auto i = m_tile_index.find(tile);
+
+            if ( i == m_tile_index.end() ) {
+                if ( m_tile_index.size() > UINT16_MAX ) {
+                    throw app::Error("Tile set is limited to {} unique tiles", UINT16_MAX + 1);
+                }
+
+                i = m_tile_index.emplace(std::move(tile), static_cast<uint16_t>(m_tile_index.size())).first;
+                align_pixels(0, m_glyph_align);
+                m_tile_size = static_cast<uint32_t>(m_pixel_data.size() - start);
+            } else {
+                // identical tile already in tile set, so discard this copy
+                m_pixel_data.resize(start);
+            }
+
+            m_tile_map.push_back(i->second);
+        }
+    }
+}
+
+
+void OutputModel::add_kerning(const app::Font& font) {
+    std::vector<unsigned int> indices;
+
+    m_kerning.clear();
+
+    if ( !font.has_kerning() ) {
+        return;
+    }
+
+    if ( m_glyphs.size() > UINT16_MAX ) {
+        throw app::Error("Kerning is limited to fonts with at most {} glyphs", UINT16_MAX);
+    }
+
+    for (const auto& glyph: m_glyphs) {
+        indices.push_back(font.char_index(glyph.codepoint));
+    }
+
+    auto add_pair = [&](size_t l, size_t r, int x_adjust) {
+        if ( x_adjust != 0 ) {
+            m_kerning.push_back({
+                    .left = static_cast<uint16_t>(l),
+                    .right = static_cast<uint16_t>(r),
+                    .x_adjust = static_cast<int16_t>(x_adjust)
+            });
+        }
+    };
+
+    auto pairs = font.kerning_pairs();
+
+    if ( !pairs ) {
+        // no pair table to read, so every ordered pair of emitted glyphs has to be probed
+        for (size_t l = 0; l < indices.size(); l++) {
+            for (size_t r = 0; r < indices.size(); r++) {
+                add_pair(l, r, font.kerning(indices[l], indices[r]));
+            }
+        }
+
+        return;
+    }
+
+    // emitted glyphs by font glyph index (several codepoints may share one glyph), so each pair listed in the font
+    // maps to the emitted glyphs it kerns in O(log n)
+    std::vector<std::pair<unsigned int, size_t>> by_index;
+
+    for (size_t i = 0; i < indices.size(); i++) {
+        by_index.emplace_back(indices[i], i);
+    }
+
+    std::sort(by_index.begin(), by_index.end());
+
+    auto emitted = [&](unsigned int index) {
+        return std::equal_range(by_index.begin(), by_index.end(), std::make_pair(index, size_t(0)),
+                                [](const auto& a, const auto& b) { return a.first < b.first; });
+    };
+
+    for (const auto& [left, right]: *pairs) {
+        auto lefts = emitted(left);
+        auto rights = emitted(right);
+
+        if ( lefts.first == lefts.second || rights.first == rights.second ) {
+            continue;
+        }
+
+        // values still come from FreeType, so they are scaled and rounded exactly as before
+        int x_adjust = font.kerning(left, right);
+
+        for (auto l = lefts.first; l != lefts.second; l++) {
+            for (auto r = rights.first; r != rights.second; r++) {
+                add_pair(l->second, r->second, x_adjust);
+            }
+        }
+    }
+
+    // the runtime binary searches pairs by left then right glyph index
+    std::sort(m_kerning.begin(), m_kerning.end(), [](const auto& a, const auto& b) {
+        return (a.left != b.left) ? (a.left < b.left) : (a.right < b.right);
+    });
+}
+
+
 void OutputModel::add_pixel(uint8_t opacity) {
-    opacity >>= m_shift;
-    opacity <<= m_bit_pos;
+    if ( !m_palette.empty() ) {
+        // pre-blended colour, one whole byte at a time in the requested byte order
+        uint32_t color = m_palette[((opacity * (m_palette.size() - 1)) + 127) / 255];
+        int n_bytes = m_depth / 8;
+
+        for (int i = 0; i < n_bytes; i++) {
+            write_bits((color >> ((m_big_endian ? (n_bytes - 1 - i) : i) * 8)) & 0xFF, 8);
+        }
+
+        return;
+    }
+
+    if ( m_planar ) {
+        m_plane_values.push_back(m_codes[opacity]);
+        return;
+    }
+
+    write_bits(m_codes[opacity], m_glyph_depth);
+}
+
+
+void OutputModel::reorder(const std::vector<size_t>& order) {
+    std::vector<uint8_t> pixel_data;
+
+    assert(order.size() == m_glyphs.size());
+    pixel_data.reserve(m_pixel_data.size());
+
+    for (auto index: order) {
+        auto& glyph = m_glyphs[index];
+        auto begin = m_pixel_data.begin() + glyph.offset;
+
+        while ( (pixel_data.size() % m_glyph_align) != 0 ) {
+            pixel_data.push_back(0);
+        }
+
+        glyph.offset = static_cast<uint32_t>(pixel_data.size());
+        pixel_data.insert(pixel_data.end(), begin, begin + m_glyph_sizes[index]);
+    }
+
+    m_pixel_data = std::move(pixel_data);
+}
+
 
-    m_current_byte |= opacity;
-    m_bit_pos += m_delta;
+void OutputModel::order_by_frequency(const app::CharCounts& counts) {
+    std::vector<uint64_t> glyph_counts(m_glyphs.size(), 0);
+    std::vector<size_t> order(m_glyphs.size());
 
-    if ( m_bit_pos < 0 || m_bit_pos >= 8 ) {
-        flush_pixels();
+    for (size_t i = 0; i < m_glyphs.size(); i++) {
+        auto count = counts.find(m_glyphs[i].codepoint);
+
+        if ( count != counts.end() ) {
+            glyph_counts[i] = count->second;
+        }
+    }
+
+    // most frequent glyphs first; unused glyphs keep codepoint order at the end
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&glyph_counts](size_t a, size_t b) { return glyph_counts[a] > glyph_counts[b]; });
+
+    reorder(order);
+}
+
+
+void OutputModel::split_hot(const app::CharSet& hot_set) {
+    std::vector<size_t> placed(m_glyphs.size());
+    std::vector<size_t> order;
+    size_t n_hot;
+
+    // keep each section in current pixel order, so that a frequency order survives the split
+    std::iota(placed.begin(), placed.end(), 0);
+    std::stable_sort(placed.begin(), placed.end(),
+                     [this](size_t a, size_t b) { return m_glyphs[a].offset < m_glyphs[b].offset; });
+
+    for (auto i: placed) {
+        if ( hot_set.count(m_glyphs[i].codepoint) ) {
+            order.push_back(i);
+        }
+    }
+
+    n_hot = order.size();
+
+    for (auto i: placed) {
+        if ( !hot_set.count(m_glyphs[i].codepoint) ) {
+            order.push_back(i);
+        }
+    }
+
+    reorder(order);
+
+    // cold pixel data starts with first cold glyph, so that any alignment padding before it stays hot
+    if ( n_hot == 0 ) {
+        m_hot_size = 0;
+    } else if ( n_hot < order.size() ) {
+        m_hot_size = m_glyphs[order[n_hot]].offset;
+    } else {
+        m_hot_size = static_cast<uint32_t>(m_pixel_data.size());
     }
 }
 
 
 void OutputModel::flush_pixels() {
-    if ( m_bit_pos != m_start ) {
-        m_pixel_data.push_back(m_current_byte);
-        m_bit_pos = m_start;
-        m_current_byte = 0;
+    if ( m_bitstream ) {
+        return;
+    }
+
+    if ( m_planar ) {
+        m_plane_lines.push_back(m_plane_values.size());
+        return;
+    }
+
+    m_bit_pos = 0;
+    align_pixels(m_line_base, m_row_align);
+}
+
+
+void OutputModel::write_bits(uint32_t value, int n_bits) {
+    for (int i = 0; i < n_bits; i++) {
+        uint32_t bit = m_msb_first ? (value >> (n_bits - 1 - i)) & 1 : (value >> i) & 1;
+
+        if ( m_bit_pos == 0 ) {
+            m_pixel_data.push_back(0);
+        }
+
+        m_pixel_data.back() |= static_cast<uint8_t>(bit << (m_msb_first ? (7 - m_bit_pos) : m_bit_pos));
+        m_bit_pos = (m_bit_pos + 1) & 7;
+    }
+}
+
+
+uint32_t OutputModel::current_offset() const {
+    if ( m_tile_width ) {
+        return static_cast<uint32_t>(m_tile_map.size());
+    } else if ( m_bitstream ) {
+        return static_cast<uint32_t>((m_pixel_data.size() * 8) - (m_bit_pos ? (8 - m_bit_pos) : 0));
+    } else {
+        return static_cast<uint32_t>(m_pixel_data.size());
+    }
+}
+
+
+uint32_t OutputModel::glyph_size(size_t index) const {
+    return m_glyph_sizes[index];
+}
+
+
+uint32_t OutputModel::glyph_stride() const {
+    return (m_glyphs.size() > 1) ? m_glyphs[1].offset : current_offset();
+}
+
+
+void OutputModel::align_pixels(size_t base, int alignment) {
+    while ( ((m_pixel_data.size() - base) % alignment) != 0 ) {
+        m_pixel_data.push_back(0);
+    }
+}
+
+
+static std::string table_attributes(std::string_view section, int align) {
+    std::string attributes;
+
+    if ( !section.empty() ) {
+        attributes += fmt::format("section(\"{}\")", section);
+    }
+
+    if ( align > 1 ) {
+        attributes += fmt::format("{}aligned({})", attributes.empty() ? "" : ", ", align);
+    }
+
+    return attributes.empty() ? attributes : fmt::format(" __attribute__(({}))", attributes);
+}
+
+
+static void write_words(FILE* f, std::string_view name, const uint8_t* data, size_t size, bool big_endian,
+                        std::string_view attributes) {
+    size_t n_words = (size + 3) / 4;
+
+    fmt::print(f, "static const uint32_t {}[{}]{} = {{\n    ", name, n_words, attributes);
+
+    int count = 0;
+
+    for (size_t i = 0; i < n_words; i++) {
+        uint32_t word = 0;
+
+        for (size_t j = 0; j < 4; j++) {
+            uint32_t byte = ((i * 4) + j < size) ? data[(i * 4) + j] : 0;
+
+            word |= byte << (big_endian ? (24 - (j * 8)) : (j * 8));
+        }
+
+        fmt::print(f, "0x{:08X}, ", word);
+        count++;
+
+        if ( count == 8 ) {
+            fmt::print(f, "\n    ");
+            count = 0;
+        }
     }
+
+    if ( count > 0 ) {
+        fmt::print(f, "\n");
+    }
+
+    fmt::print(f, "}};\n\n\n");
+}
+
+
+static void write_bytes(FILE* f, std::string_view name, const uint8_t* data, size_t size,
+                        std::string_view attributes) {
+    fmt::print(f, "static const uint8_t {}[{}]{} = {{\n    ", name, size, attributes);
+
+    int count = 0;
+
+    for (size_t i = 0; i < size; i++) {
+        fmt::print(f, "0x{:02X}, ", data[i]);
+        count++;
+
+        if ( count == 16 ) {
+            fmt::print(f, "\n    ");
+            count = 0;
+        }
+    }
+
+    if ( count > 0 ) {
+        fmt::print(f, "\n");
+    }
+
+    fmt::print(f, "}};\n\n\n");
 }
 
 
@@ -151,7 +806,11 @@ void OutputModel::write(std::string_view path, std::string_view font_path, const
     };
 
     File f(path);
-    size_t total_size = m_pixel_data.size() + (m_glyphs.size() * sizeof(font2c_glyph_t));
+    bool monospace = is_monospace();
+    bool external = !options.external_path.empty();
+    bool words = !options.word_output.empty();
+    std::vector<font2c_range_t> ranges = monospace ? mono_ranges() : std::vector<font2c_range_t>();
+    size_t total_size = memory_size(external);
 
     fmt::print(f, "/*\n");
     fmt::print(f, " * Generated by font2c, version {}\n", APP_VERSION_STR);
@@ -165,57 +824,308 @@ void OutputModel::write(std::string_view path, std::string_view font_path, const
     fmt::print(f, " *\n");
     fmt::print(f, " * Source Font:          {}\n", std::filesystem::path(font_path).filename().string());
     fmt::print(f, " * Font Size:            {}px\n", options.size);
-    fmt::print(f, " * Pixel Depth:          {}bpp\n", options.pixel_depth);
+    auto n_mixed = std::count_if(m_glyphs.begin(), m_glyphs.end(), [](const auto& glyph) { return glyph.depth; });
+    bool mixed_depth = (n_mixed > 0);
+
+    if ( mixed_depth ) {
+        fmt::print(f, " * Pixel Depth:          {}bpp ({} glyphs at other depths)\n", m_depth, n_mixed);
+    } else {
+        fmt::print(f, " * Pixel Depth:          {}bpp\n", m_depth);
+    }
     fmt::print(f, " * Raster Order:         {}\n", options.raster_type);
     fmt::print(f, " * Bit Order:            {}\n", options.msb_first ? "msb first" : "lsb first");
     fmt::print(f, " * Anti-aliased:         {}\n", options.antialiasing ? "yes" : "no");
     fmt::print(f, " * Hinting:              {}\n", options.no_hinting ? "no" : "yes");
     fmt::print(f, " * Center Adjustment:    {}\n", options.center_adjust);
+    fmt::print(f, " * Layout:               {}\n", monospace ? "monospace" : "proportional");
+
+    if ( !m_palette.empty() ) {
+        fmt::print(f, " * Color Format:         {}, {} levels, {} endian\n", options.color_format, m_palette.size(),
+                   m_big_endian ? "big" : "little");
+    }
+
+    if ( m_palette.empty() && m_depth < 8 ) {
+        std::string method = m_levels.empty() ? (m_dither ? "evenly spaced levels" : "truncated") : "optimal levels";
+
+        std::string psnr_text = std::isinf(psnr()) ? "lossless" :
+                fmt::format("PSNR {:.2f} dB ({:.2f} dB blurred)", psnr(), psnr(true));
+
+        fmt::print(f, " * Quantization:         {}{}, {}\n", method, m_dither ? ", dithered" : "", psnr_text);
+    }
+
+    if ( m_hot_size > 0 ) {
+        fmt::print(f, " * Hot Pixels:           {} bytes\n", m_hot_size);
+    }
+
+    if ( m_tile_width ) {
+        fmt::print(f, " * Tiles:                {} unique {}x{} tiles of {} bytes, {} map entries\n",
+                   m_tile_index.size(), m_tile_width, m_tile_height, m_tile_size, m_tile_map.size());
+    }
+
+    if ( m_bitstream ) {
+        fmt::print(f, " * Packing:              bitstream (glyph offsets in bits)\n");
+    } else if ( m_planar ) {
+        fmt::print(f, " * Packing:              planar ({} bit-planes per glyph)\n", m_depth);
+    }
+
+    if ( m_row_align > 1 || m_glyph_align > 1 ) {
+        fmt::print(f, " * Alignment:            {} byte rows, {} byte glyphs\n", m_row_align, m_glyph_align);
+    }
+
+    if ( words ) {
+        fmt::print(f, " * Word Output:          32-bit {} endian\n", (options.word_output == "be") ? "big" : "little");
+    }
+
+    if ( !m_fallback.empty() ) {
+        fmt::print(f, " * Fallback:             {}\n", m_fallback);
+    }
+
     fmt::print(f, " * Glyph Count:          {}\n", m_glyphs.size());
+    fmt::print(f, " * Kerning Pairs:        {}\n", m_kerning.size());
     fmt::print(f, " * Mem Usage (approx):   {} bytes\n", total_size);
+
+    if ( external ) {
+        fmt::print(f, " * External Pixels:      {} bytes in {}\n", m_pixel_data.size(),
+                   std::filesystem::path(options.external_path).filename().string());
+    }
+
     fmt::print(f, " */\n\n");
 
     fmt::print(f, "#include <font2c-types.h>\n\n\n");
 
-    fmt::print(f, "static const uint8_t PIXELS[{}] = {{\n    ", m_pixel_data.size());
+    // the runtime reads pixel data a byte at a time, so words must be stored in the target's own byte order, and
+    // it reads RGB565 and ARGB8888 pixels as native words, so they must be too
+    std::string order_option;
+    bool big_endian = false;
 
-    int count = 0;
+    if ( words ) {
+        order_option = fmt::format("--word-output={}", options.word_output);
+        big_endian = (options.word_output == "be");
+    } else if ( !m_palette.empty() && options.color_format != "rgb888" ) {
+        order_option = fmt::format("--color-endian={}", options.color_endian);
+        big_endian = m_big_endian;
+    }
 
-    for (auto byte: m_pixel_data) {
-        fmt::print(f, "0x{:02X}, ", byte);
-        count++;
+    if ( !order_option.empty() ) {
+        fmt::print(f, "#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ != {})\n",
+                   big_endian ? "__ORDER_BIG_ENDIAN__" : "__ORDER_LITTLE_ENDIAN__");
+        fmt::print(f, "#error \"Pixel data was generated with {} for {}-endian targets\"\n",
+                   order_option, big_endian ? "big" : "little");
+        fmt::print(f, "#endif\n\n\n");
+    }
 
-        if ( count == 16 ) {
-            fmt::print(f, "\n    ");
-            count = 0;
+    // glyph and row alignment only hold in memory if the pixel tables are at least as aligned themselves
+    int pixel_align = std::max(options.align, m_glyph_align);
+    std::string attributes = table_attributes(options.section, options.align);
+    std::string pixel_attributes = table_attributes(options.section, pixel_align);
+    std::string hot_attributes = table_attributes(options.hot_section, pixel_align);
+    bool cold = (m_pixel_data.size() > m_hot_size);
+
+    auto write_pixels = [&](std::string_view name, const uint8_t* data, size_t size, std::string_view attr) {
+        if ( words ) {
+            write_words(f, name, data, size, options.word_output == "be", attr);
+        } else {
+            write_bytes(f, name, data, size, attr);
         }
+    };
+
+    if ( m_hot_size > 0 ) {
+        write_pixels("HOT_PIXELS", m_pixel_data.data(), m_hot_size, hot_attributes);
     }
 
-    if ( count > 0 ) {
-        fmt::print(f, "\n");
+    if ( !external && cold ) {
+        write_pixels(m_tile_width ? "TILES" : "PIXELS", m_pixel_data.data() + m_hot_size,
+                     m_pixel_data.size() - m_hot_size, pixel_attributes);
     }
 
-    fmt::print(f, "}};\n\n\n");
+    if ( monospace ) {
+        fmt::print(f, "static const font2c_range_t RANGES[{}]{} = {{\n", ranges.size(), attributes);
 
-    fmt::print(f, "static const font2c_glyph_t GLYPHS[{}] = {{\n", m_glyphs.size());
+        for (const auto& range: ranges) {
+            fmt::print(f, "    {{0x{:08X}, {:>6}, {:>6}}},\n", range.first, range.count, range.index);
+        }
 
-    for (const auto& glyph: m_glyphs) {
-        fmt::print(f, "    {{0x{:08X}, 0x{:08X}, {:>6}, {:>6}, {:>6}, {:>6}, {:>6}}},\n",
-                   glyph.codepoint, glyph.offset, glyph.x_bearing, glyph.y_bearing,
-                   glyph.width, glyph.height, glyph.x_advance);
+        fmt::print(f, "}};\n\n\n");
+    } else if ( !m_glyphs.empty() ) {
+        fmt::print(f, "static const font2c_glyph_t GLYPHS[{}]{} = {{\n", m_glyphs.size(), attributes);
+
+        for (const auto& glyph: m_glyphs) {
+            // every field is written, so the table stays clean under -Wmissing-field-initializers
+            fmt::print(f, "    {{0x{:08X}, 0x{:08X}, {:>6}, {:>6}, {:>6}, {:>6}, {:>6}, {}}},\n",
+                       glyph.codepoint, glyph.offset, glyph.x_bearing, glyph.y_bearing,
+                       glyph.width, glyph.height, glyph.x_advance, glyph.depth);
+        }
+
+        fmt::print(f, "}};\n\n\n");
     }
 
-    fmt::print(f, "}};\n\n\n");
+    if ( m_tile_width ) {
+        fmt::print(f, "static const uint16_t TILE_MAP[{}]{} = {{\n    ", m_tile_map.size(), attributes);
+
+        int count = 0;
+
+        for (auto tile: m_tile_map) {
+            fmt::print(f, "{:>5}, ", tile);
+            count++;
+
+            if ( count == 16 ) {
+                fmt::print(f, "\n    ");
+                count = 0;
+            }
+        }
+
+        if ( count > 0 ) {
+            fmt::print(f, "\n");
+        }
+
+        fmt::print(f, "}};\n\n\n");
+    }
+
+    if ( !m_levels.empty() ) {
+        fmt::print(f, "static const uint8_t LEVELS[{}]{} = {{\n", m_levels.size(), attributes);
+
+        for (size_t i = 0; i < m_levels.size(); i++) {
+            bool line_end = ((i % 16) == 15) || ((i + 1) == m_levels.size());
+
+            fmt::print(f, "{}0x{:02X},{}", ((i % 16) == 0) ? "    " : "", m_levels[i], line_end ? "\n" : " ");
+        }
+
+        fmt::print(f, "}};\n\n\n");
+    }
+
+    if ( !m_kerning.empty() ) {
+        fmt::print(f, "static const font2c_kerning_t KERNING[{}]{} = {{\n", m_kerning.size(), attributes);
+
+        for (const auto& pair: m_kerning) {
+            fmt::print(f, "    {{{:>6}, {:>6}, {:>6}}},\n", pair.left, pair.right, pair.x_adjust);
+        }
+
+        fmt::print(f, "}};\n\n\n");
+    }
+
+    if ( !m_fallback.empty() ) {
+        fmt::print(f, "extern const font2c_font_t {};\n\n\n", m_fallback);
+    }
 
     fmt::print(f, "const font2c_font_t {} = {{\n", options.symbol_name);
-    fmt::print(f, "    .pixels =       PIXELS,\n");
-    fmt::print(f, "    .glyphs =       GLYPHS,\n");
+    std::string pixels = fmt::format(words ? "(const uint8_t*) {}" : "{}", m_tile_width ? "TILES" : "PIXELS");
+
+    fmt::print(f, "    .pixels =       {},\n", (external || !cold) ? "NULL" : pixels);
+    // a locale shard whose characters are all in its base shard has no glyphs of its own
+    fmt::print(f, "    .glyphs =       {},\n", (monospace || m_glyphs.empty()) ? "NULL" : "GLYPHS");
     fmt::print(f, "    .n_glyphs =     {},\n", m_glyphs.size());
     fmt::print(f, "    .ascent =       {},\n", m_line_ascent);
     fmt::print(f, "    .descent =      {},\n", m_line_descent);
     fmt::print(f, "    .center =       {},\n", (m_line_ascent / 2) + options.center_adjust);
     fmt::print(f, "    .line_height =  {},\n", m_line_height);
-    fmt::print(f, "    .compression =  FONT2C_COMPRESSION_NONE\n");
+    fmt::print(f, "    .compression =  FONT2C_COMPRESSION_NONE,\n");
+
+    std::string flags;
+
+    if ( monospace ) {
+        flags += "FONT2C_FLAG_MONOSPACE";
+    }
+
+    if ( options.msb_first ) {
+        flags += flags.empty() ? "FONT2C_FLAG_MSB_FIRST" : " | FONT2C_FLAG_MSB_FIRST";
+    }
+
+    if ( external ) {
+        flags += flags.empty() ? "FONT2C_FLAG_EXTERNAL" : " | FONT2C_FLAG_EXTERNAL";
+    }
+
+    if ( m_bitstream ) {
+        flags += flags.empty() ? "FONT2C_FLAG_BITSTREAM" : " | FONT2C_FLAG_BITSTREAM";
+    }
+
+    if ( m_tile_width ) {
+        flags += flags.empty() ? "FONT2C_FLAG_TILED" : " | FONT2C_FLAG_TILED";
+    }
+
+    if ( !m_palette.empty() ) {
+        flags += flags.empty() ? "FONT2C_FLAG_COLOR" : " | FONT2C_FLAG_COLOR";
+    }
+
+    if ( m_planar ) {
+        flags += flags.empty() ? "FONT2C_FLAG_PLANAR" : " | FONT2C_FLAG_PLANAR";
+    }
+
+    fmt::print(f, "    .flags =        {},\n", flags.empty() ? "0" : flags);
+
+    if ( monospace ) {
+        const auto& glyph = m_glyphs.front();
+
+        fmt::print(f, "    .ranges =       RANGES,\n");
+        fmt::print(f, "    .n_ranges =     {},\n", ranges.size());
+        fmt::print(f, "    .glyph_size =   {},\n", glyph_stride());
+        fmt::print(f, "    .mono_glyph =   {{0, 0, {}, {}, {}, {}, {}}},\n", glyph.x_bearing, glyph.y_bearing,
+                   glyph.width, glyph.height, glyph.x_advance);
+    }
+
+    if ( !m_kerning.empty() ) {
+        fmt::print(f, "    .kerning =      KERNING,\n");
+        fmt::print(f, "    .n_kerning =    {},\n", m_kerning.size());
+    }
+
+    std::string raster = options.raster_type;
+    std::transform(raster.begin(), raster.end(), raster.begin(), ::toupper);
+
+    std::vector<std::pair<std::string_view, std::string>> fields;
+
+    fields.emplace_back("depth", fmt::format("{}", m_depth));
+    fields.emplace_back("raster", fmt::format("FONT2C_RASTER_{}", raster));
+
+    if ( m_hot_size > 0 ) {
+        fields.emplace_back("hot_pixels", words ? "(const uint8_t*) HOT_PIXELS" : "HOT_PIXELS");
+        fields.emplace_back("hot_size", fmt::format("{}", m_hot_size));
+    }
+
+    if ( m_row_align > 1 ) {
+        fields.emplace_back("row_align", fmt::format("{}", m_row_align));
+    }
+
+    if ( m_tile_width ) {
+        fields.emplace_back("tile_map", "TILE_MAP");
+        fields.emplace_back("tile_width", fmt::format("{}", m_tile_width));
+        fields.emplace_back("tile_height", fmt::format("{}", m_tile_height));
+        fields.emplace_back("tile_size", fmt::format("{}", m_tile_size));
+    }
+
+    if ( !m_palette.empty() ) {
+        std::string format = options.color_format;
+
+        std::transform(format.begin(), format.end(), format.begin(), ::toupper);
+        fields.emplace_back("format", fmt::format("FONT2C_FORMAT_{}", format));
+    }
+
+    if ( !m_levels.empty() ) {
+        fields.emplace_back("levels", "LEVELS");
+    }
+
+    if ( !m_fallback.empty() ) {
+        fields.emplace_back("fallback", fmt::format("&{}", m_fallback));
+    }
+
+    for (size_t i = 0; i < fields.size(); i++) {
+        fmt::print(f, "    {:<16}{}{}\n", fmt::format(".{} =", fields[i].first), fields[i].second,
+                   ((i + 1) < fields.size()) ? "," : "");
+    }
+
     fmt::print(f, "}};\n\n\n");
     fmt::print(f, "/* === end of file === */\n\n");
 }
+
+
+void OutputModel::write_pixels(std::string_view path) const {
+    std::ofstream ofs(path.data(), std::ios::binary);
+
+    if ( !ofs ) {
+        throw app::Error("Unable to create pixel file '{}'", path);
+    }
+
+    ofs.write(reinterpret_cast<const char*>(m_pixel_data.data()), static_cast<std::streamsize>(m_pixel_data.size()));
+
+    if ( !ofs ) {
+        throw app::Error("Unable to write pixel file '{}'", path);
+    }
+}
@@ -21,14 +21,17 @@
 #pragma once
 
 #include <functional>
+#include <map>
 #include <optional>
 #include <string_view>
 #include <vector>
 
 #include <font2c-types.h>
 
+#include "app-char-set.hpp"
 #include "app-glyph.hpp"
 #include "app-options.hpp"
+#include "app-quantize.hpp"
 
 
 namespace app {
@@ -38,8 +41,24 @@ namespace app {
 
         typedef std::function<void (app::OutputModel& output_model, const app::Glyph& glyph)> RasterizerFunc;
 
+        struct ReadCount {
+            size_t uncoalesced;
+            size_t coalesced;
+        };
+
+        struct Footprint {
+            size_t lines;
+            size_t hot_lines;
+        };
+
         OutputModel(int depth, bool msb_first, RasterizerFunc rasterizer_func, std::string_view cmd_line = std::string());
 
+        [[nodiscard]]
+        int depth() const;
+
+        [[nodiscard]]
+        int page_height() const;
+
         [[nodiscard]]
         int line_ascent() const;
 
@@ -55,29 +74,115 @@ namespace app {
         [[nodiscard]]
         const std::vector<uint8_t>& pixel_data() const;
 
-        void add_glyph(const app::Glyph& glyph);
+        [[nodiscard]]
+        bool is_monospace() const;
+
+        [[nodiscard]]
+        double psnr(bool blurred = false) const;
+
+        [[nodiscard]]
+        size_t memory_size(bool external) const;
+
+        [[nodiscard]]
+        ReadCount count_reads(std::u32string_view text, uint32_t max_gap) const;
+
+        [[nodiscard]]
+        Footprint cache_footprint(const app::CharCounts& counts, uint32_t line_size) const;
+
+        void set_alignment(int row_align, int glyph_align);
+
+        void set_bitstream(bool bitstream);
+
+        void set_tiles(int width, int height);
+
+        void set_palette(std::vector<uint32_t> palette, bool big_endian);
+
+        void set_planar(bool planar);
+
+        void set_quantization(std::vector<uint8_t> levels, bool dither);
+
+        void set_fallback(std::string_view symbol);
+
+        void set_line_metrics(int ascent, int descent, int height);
+
+        void add_glyph(const app::Glyph& glyph, int depth = 0);
+
+        void add_kerning(const app::Font& font);
 
         void add_pixel(uint8_t opacity);
 
+        void reorder(const std::vector<size_t>& order);
+
+        void order_by_frequency(const app::CharCounts& counts);
+
+        void split_hot(const app::CharSet& hot_set);
+
         void flush_pixels();
 
         void write(std::string_view path, std::string_view font_path, const app::Options& options) const;
 
+        void write_pixels(std::string_view path) const;
+
 
     private:
 
+        [[nodiscard]]
+        uint32_t glyph_size(size_t index) const;
+
+        [[nodiscard]]
+        uint32_t glyph_stride() const;
+
+        [[nodiscard]]
+        uint32_t current_offset() const;
+
+        [[nodiscard]]
+        std::vector<font2c_range_t> mono_ranges() const;
+
+        void align_pixels(size_t base, int alignment);
+
+        void write_bits(uint32_t value, int n_bits);
+
+        void measure_error(const app::Glyph& glyph, const app::Glyph& quantized, const std::vector<uint8_t>& levels);
+
+        void rasterize(const app::Glyph& glyph);
+
+        void add_tiles(const app::Glyph& glyph);
+
         const RasterizerFunc m_rasterizer_func;
         const std::string m_cmd_line;
-        int m_shift;
-        int m_start;
-        int m_delta;
+        const int m_depth;
+        const bool m_msb_first;
         int m_line_ascent;
         int m_line_descent;
         int m_line_height;
         int m_bit_pos;
-        uint8_t m_current_byte;
+        bool m_bitstream;
+        int m_row_align;
+        int m_glyph_align;
+        uint32_t m_hot_size;
+        size_t m_line_base;
+        int m_tile_width;
+        int m_tile_height;
+        uint32_t m_tile_size;
         std::vector<font2c_glyph_t> m_glyphs;
+        std::vector<uint32_t> m_glyph_sizes;
+        std::vector<font2c_kerning_t> m_kerning;
         std::vector<uint8_t> m_pixel_data;
+        std::vector<uint16_t> m_tile_map;
+        std::vector<uint32_t> m_palette;
+        bool m_big_endian;
+        bool m_planar;
+        int m_glyph_depth;
+        std::vector<uint8_t> m_plane_values;
+        std::vector<size_t> m_plane_lines;
+        std::map<std::vector<uint8_t>, uint16_t> m_tile_index;
+        std::vector<uint8_t> m_levels;
+        bool m_dither;
+        app::QuantizeTable m_codes;
+        double m_squared_error;
+        double m_blurred_error;
+        uint64_t m_n_pixels;
+        std::string m_fallback;
     };
 
 }
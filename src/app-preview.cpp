@@ -20,11 +20,15 @@
 
 #include "app-canvas.hpp"
 #include "app-preview.hpp"
+#include "app-quantize.hpp"
 
 
 void app::preview_generate(std::string_view path, app::Font& font, const app::CharSet& char_set, int depth,
-                      bool antialiasing, bool no_hinting) {
+                      bool antialiasing, bool no_hinting, const std::vector<uint8_t>& levels, bool dither) {
     int total_width = 0;
+    bool quantized = dither || !levels.empty();
+    std::vector<uint8_t> preview_levels = levels.empty() ? app::quantize_levels(depth) : levels;
+    app::QuantizeTable table = app::quantize_table(preview_levels);
 
     app::OutputModel output_model(8, false, [=] (app::OutputModel& output_model, const app::Glyph& glyph) {
         int pitch = glyph.pitch();
@@ -38,7 +42,12 @@ void app::preview_generate(std::string_view path, app::Font& font, const app::Ch
             const uint8_t* pixel_e = pixel_i + glyph.width();
 
             while (pixel_i < pixel_e) {
-                output_model.add_pixel(scale * (*pixel_i >> shift));
+                if (quantized) {
+                    output_model.add_pixel(preview_levels[table[*pixel_i]]);
+                } else {
+                    output_model.add_pixel(scale * (*pixel_i >> shift));
+                }
+
                 pixel_i += 1;
             }
 
@@ -51,7 +60,15 @@ void app::preview_generate(std::string_view path, app::Font& font, const app::Ch
         try {
             app::Glyph glyph(font, codepoint, antialiasing, no_hinting);
             total_width += glyph.x_bearing() + glyph.width() + 4;
-            output_model.add_glyph(glyph);
+            if (dither) {
+                // dither a copy so the preview shows the same pixels as the generated font
+                app::Glyph copy = glyph.crop(glyph.bounds());
+
+                app::quantize_dither(copy.buffer(), copy.width(), copy.height(), copy.pitch(), preview_levels, table);
+                output_model.add_glyph(copy);
+            } else {
+                output_model.add_glyph(glyph);
+            }
         } catch(app::GlyphError&) {
             // ignore
         }
@@ -21,6 +21,7 @@
 #pragma once
 
 #include <string_view>
+#include <vector>
 
 #include "app-char-set.hpp"
 #include "app-font.hpp"
@@ -30,6 +31,7 @@
 namespace app {
 
     void preview_generate(std::string_view path, app::Font& font, const app::CharSet& char_set, int depth,
-                          bool antialiasing, bool no_hinting);
+                          bool antialiasing, bool no_hinting, const std::vector<uint8_t>& levels = {},
+                          bool dither = false);
 
 }
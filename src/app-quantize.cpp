@@ -0,0 +1,163 @@
+/*
+ * font2c - Command-line utility for converting font glyphs into bitmap images
+ * embeddable in C source code.
+ *
+ * https://github.com/mattbucknall/font2c
+ *
+ * Copyright (C) 2022 Matthew T. Bucknall
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "app-quantize.hpp"
+
+
+std::vector<uint8_t> app::quantize_levels(int depth) {
+    std::vector<uint8_t> levels;
+    uint32_t max = (1u << depth) - 1;
+
+    // evenly spaced levels, rounded exactly as font2c_expand() expands them at runtime, which also treats 1bpp as
+    // plain off/on (the rounding term would otherwise carry both levels one step too high)
+    if ( depth == 1 ) {
+        return {0x00, 0xFF};
+    }
+
+    for (uint32_t i = 0; i <= max; i++) {
+        levels.push_back(static_cast<uint8_t>(((i * 255) + ((max + 1) >> 1)) / max));
+    }
+
+    return levels;
+}
+
+
+std::vector<uint8_t> app::quantize_levels(const Histogram& histogram, int depth) {
+    std::vector<uint8_t> initial = quantize_levels(depth);
+    std::vector<double> level(initial.begin(), initial.end());
+    size_t n = level.size();
+
+    // Lloyd-Max: move each level to the centroid of the coverage values nearest to it until nothing moves. The
+    // end levels stay pinned at 0 and 255 so that blank and solid pixels are always reproduced exactly.
+    for (int iteration = 0; iteration < 100; iteration++) {
+        double movement = 0.0;
+
+        for (size_t i = 1; (i + 1) < n; i++) {
+            double lower = (level[i - 1] + level[i]) / 2.0;
+            double upper = (level[i] + level[i + 1]) / 2.0;
+            double sum = 0.0;
+            double count = 0.0;
+
+            for (int v = static_cast<int>(std::floor(lower)) + 1; v <= upper && v < 256; v++) {
+                sum += static_cast<double>(v) * static_cast<double>(histogram[v]);
+                count += static_cast<double>(histogram[v]);
+            }
+
+            if ( count > 0.0 ) {
+                movement = std::max(movement, std::fabs((sum / count) - level[i]));
+                level[i] = sum / count;
+            }
+        }
+
+        if ( movement < 0.01 ) {
+            break;
+        }
+    }
+
+    // rounding can make neighbouring levels collide, so keep them strictly increasing
+    std::vector<uint8_t> levels(n);
+
+    for (size_t i = 0; i < n; i++) {
+        long v = std::lround(level[i]);
+
+        if ( i > 0 ) {
+            v = std::max(v, static_cast<long>(levels[i - 1]) + 1);
+        }
+
+        levels[i] = static_cast<uint8_t>(std::min(v, 255L - static_cast<long>(n - 1 - i)));
+    }
+
+    return levels;
+}
+
+
+app::QuantizeTable app::quantize_table(const std::vector<uint8_t>& levels) {
+    QuantizeTable table;
+    size_t code = 0;
+
+    // levels are increasing, so the nearest level never moves backwards as coverage increases
+    for (int v = 0; v < 256; v++) {
+        while ( (code + 1) < levels.size() && (levels[code + 1] - v) < (v - levels[code]) ) {
+            code++;
+        }
+
+        table[v] = static_cast<uint8_t>(code);
+    }
+
+    return table;
+}
+
+
+app::QuantizeTable app::quantize_table(int depth) {
+    QuantizeTable table;
+
+    // plain truncation, as used when neither dithering nor optimal levels are requested
+    for (int v = 0; v < 256; v++) {
+        table[v] = static_cast<uint8_t>(v >> (8 - depth));
+    }
+
+    return table;
+}
+
+
+void app::quantize_dither(uint8_t* pixels, int width, int height, int pitch, const std::vector<uint8_t>& levels,
+                          const QuantizeTable& table) {
+    // Floyd-Steinberg error diffusion, errors held in sixteenths for this row and the next
+    std::vector<int> this_row(width + 2);
+    std::vector<int> next_row(width + 2);
+
+    for (int y = 0; y < height; y++) {
+        uint8_t* row = pixels + (y * pitch);
+
+        std::fill(next_row.begin(), next_row.end(), 0);
+
+        for (int x = 0; x < width; x++) {
+            // blank pixels stay blank, so diffused error never sprinkles ink outside the glyph's outline
+            if ( row[x] == 0 ) {
+                continue;
+            }
+
+            int value = std::clamp(row[x] + (this_row[x + 1] / 16), 0, 255);
+            uint8_t level = levels[table[value]];
+            int error = value - level;
+
+            row[x] = level;
+            this_row[x + 2] += error * 7;
+            next_row[x] += error * 3;
+            next_row[x + 1] += error * 5;
+            next_row[x + 2] += error;
+        }
+
+        std::swap(this_row, next_row);
+    }
+}
+
+
+double app::quantize_psnr(double squared_error, uint64_t n_pixels) {
+    if ( squared_error <= 0.0 || n_pixels == 0 ) {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    return 10.0 * std::log10((255.0 * 255.0) / (squared_error / static_cast<double>(n_pixels)));
+}
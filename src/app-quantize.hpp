@@ -0,0 +1,45 @@
+/*
+ * font2c - Command-line utility for converting font glyphs into bitmap images
+ * embeddable in C source code.
+ *
+ * https://github.com/mattbucknall/font2c
+ *
+ * Copyright (C) 2022 Matthew T. Bucknall
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+
+namespace app {
+    typedef std::array<uint64_t, 256> Histogram;
+
+    typedef std::array<uint8_t, 256> QuantizeTable;
+
+    std::vector<uint8_t> quantize_levels(int depth);
+
+    std::vector<uint8_t> quantize_levels(const Histogram& histogram, int depth);
+
+    QuantizeTable quantize_table(const std::vector<uint8_t>& levels);
+
+    QuantizeTable quantize_table(int depth);
+
+    void quantize_dither(uint8_t* pixels, int width, int height, int pitch, const std::vector<uint8_t>& levels,
+                         const QuantizeTable& table);
+
+    double quantize_psnr(double squared_error, uint64_t n_pixels);
+}
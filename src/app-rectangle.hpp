@@ -53,6 +53,8 @@ namespace app {
         bool overlaps(const Rectangle& other) const noexcept;
 
         void intersect(const Rectangle& other) noexcept;
+
+        void unite(const Rectangle& other) noexcept;
     };
 
 
@@ -106,6 +108,22 @@ namespace app {
         y2 = std::max(other.y1, std::min(y2, other.y2));
     }
 
+
+    inline void Rectangle::unite(const Rectangle& other) noexcept {
+        if ( other.empty() ) {
+            return;
+        }
+
+        if ( empty() ) {
+            *this = other;
+        } else {
+            x1 = std::min(x1, other.x1);
+            y1 = std::min(y1, other.y1);
+            x2 = std::max(x2, other.x2);
+            y2 = std::max(y2, other.y2);
+        }
+    }
+
 #endif // _DOXYGEN
 
 }
\ No newline at end of file
@@ -0,0 +1,100 @@
+/*
+ * font2c - Command-line utility for converting font glyphs into bitmap images
+ * embeddable in C source code.
+ *
+ * https://github.com/mattbucknall/font2c
+ *
+ * Copyright (C) 2022 Matthew T. Bucknall
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <cstdint>
+#include <cstring>
+
+#include "app-utf8.hpp"
+
+
+std::u32string app::utf8_decode(std::string_view text) {
+    static const char32_t MIN_VALUE[] = {0, 0, 0x80, 0x800, 0x10000};
+    std::u32string result;
+    size_t i = 0;
+
+    result.reserve(text.size());
+
+    while (i < text.size()) {
+        uint64_t word;
+
+        // ASCII fast path: eight bytes at a time while none has its top bit set
+        if ((i + sizeof(word)) <= text.size()) {
+            std::memcpy(&word, text.data() + i, sizeof(word));
+
+            if ((word & UINT64_C(0x8080808080808080)) == 0) {
+                for (size_t j = 0; j < sizeof(word); j++) {
+                    result.push_back(static_cast<uint8_t>(text[i + j]));
+                }
+
+                i += sizeof(word);
+                continue;
+            }
+        }
+
+        auto byte = static_cast<uint8_t>(text[i]);
+        char32_t c;
+        size_t len;
+
+        if (byte < 0x80) {
+            result.push_back(byte);
+            i++;
+            continue;
+        } else if ((byte & 0xE0) == 0xC0) {
+            c = byte & 0x1F;
+            len = 2;
+        } else if ((byte & 0xF0) == 0xE0) {
+            c = byte & 0x0F;
+            len = 3;
+        } else if ((byte & 0xF8) == 0xF0) {
+            c = byte & 0x07;
+            len = 4;
+        } else {
+            throw app::Error("Invalid UTF-8 lead byte at offset {}", i);
+        }
+
+        if ((i + len) > text.size()) {
+            throw app::Error("Encountered incomplete UTF-8 sequence at offset {}", i);
+        }
+
+        for (size_t j = 1; j < len; j++) {
+            auto cont = static_cast<uint8_t>(text[i + j]);
+
+            if ((cont & 0xC0) != 0x80) {
+                throw app::Error("Invalid UTF-8 continuation byte at offset {}", i + j);
+            }
+
+            c = (c << 6) | (cont & 0x3F);
+        }
+
+        // each codepoint has exactly one valid encoding, and surrogates are UTF-16 only
+        if (c < MIN_VALUE[len]) {
+            throw app::Error("Overlong UTF-8 sequence at offset {}", i);
+        }
+
+        if ((c >= 0xD800 && c <= 0xDFFF) || c > 0x10FFFF) {
+            throw app::Error("Invalid codepoint U+{:04X} at offset {}", static_cast<uint32_t>(c), i);
+        }
+
+        result.push_back(c);
+        i += len;
+    }
+
+    return result;
+}
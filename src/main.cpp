@@ -19,19 +19,30 @@
  */
 
 #include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdio>
+#include <filesystem>
 #include <map>
+#include <memory>
+#include <optional>
 #include <sstream>
+#include <utility>
 
 #include <fmt/core.h>
 
 #include "app-arg-parser.hpp"
 #include "app-char-set.hpp"
+#include "app-color.hpp"
+#include "app-corpus.hpp"
 #include "app-error.hpp"
 #include "app-font.hpp"
 #include "app-glyph.hpp"
 #include "app-options.hpp"
 #include "app-output-model.hpp"
 #include "app-preview.hpp"
+#include "app-quantize.hpp"
+#include "app-utf8.hpp"
 #include "app-version.hpp"
 
 
@@ -44,6 +55,34 @@ struct Rasterizer {
 typedef std::map<std::string_view, Rasterizer> RasterizerMap;
 
 
+static constexpr size_t RENDER_BATCH_SIZE = 1024;
+
+
+struct Target {
+    Target(app::Options options_, std::string path_, app::CharSet char_set_ = {}):
+        options(std::move(options_)),
+        path(std::move(path_)),
+        char_set(std::move(char_set_)) {
+    }
+
+    app::Options options;
+    std::string path;
+    app::CharSet char_set;
+    std::unique_ptr<app::OutputModel> output_model;
+    std::vector<uint8_t> levels;
+    int cell_width = 1;
+    int cell_height = 1;
+    app::Rectangle mono_box;
+    int mono_x_advance = 0;
+};
+
+
+struct Render {
+    std::optional<app::Glyph> glyphs[2];
+    std::string error;
+};
+
+
 static uint8_t get_glyph_pixel(const app::Glyph& glyph, int x, int y) {
     if (x < 0 || y < 0 || x >= glyph.width() || y >= glyph.height()) {
         return 0;
@@ -171,6 +210,23 @@ static void btrl_rasterizer(app::OutputModel& output_model, const app::Glyph& gl
 }
 
 
+static void page_rasterizer(app::OutputModel& output_model, const app::Glyph& glyph) {
+    int width = glyph.width();
+    int height = glyph.height();
+    int page_height = output_model.page_height();
+
+    for (int y = 0; y < height; y += page_height) {
+        for (int x = 0; x < width; x++) {
+            for (int i = 0; i < page_height; i++) {
+                output_model.add_pixel(get_glyph_pixel(glyph, x, y + i));
+            }
+        }
+
+        output_model.flush_pixels();
+    }
+}
+
+
 static const RasterizerMap& rasterizer_map() {
     static const RasterizerMap m = {
             {"lrtb", {"Left-to-right, top-to-bottom", lrtb_rasterizer}},
@@ -180,20 +236,135 @@ static const RasterizerMap& rasterizer_map() {
             {"tblr", {"Top-to-bottom, left-to-right", tblr_rasterizer}},
             {"tbrl", {"Top-to-bottom, right-to-left", tbrl_rasterizer}},
             {"btlr", {"Bottom-to-top, left-to-right", btlr_rasterizer}},
-            {"btrl", {"Bottom-to-top, right-to-left", btrl_rasterizer}}
+            {"btrl", {"Bottom-to-top, right-to-left", btrl_rasterizer}},
+            {"page", {"Pages of vertical bytes, top pixel first (SSD1306 style)", page_rasterizer}}
     };
 
     return m;
 }
 
 
+// every check that depends on a target's options lives here, so that variants, which override the main target's
+// depth, raster type and bit order, are validated in the same way
+static void check_layout(const app::Options& options) {
+    if (options.pixel_depth < 1 || options.pixel_depth > 8) {
+        throw app::Error("Pixel depth must be 1 to 8 bits-per-pixel");
+    }
+
+    if (rasterizer_map().count(options.raster_type) == 0) {
+        throw app::Error("Unrecognized raster type: {}", options.raster_type);
+    }
+
+    if (options.raster_type == "page" && !options.planar && (8 % options.pixel_depth) != 0) {
+        throw app::Error("Page raster type requires a pixel depth of 1, 2, 4 or 8 bits-per-pixel");
+    }
+
+    if (options.optimal_levels && (options.pixel_depth < 2 || options.pixel_depth > 7)) {
+        throw app::Error("Optimal levels require a pixel depth of 2 to 7 bits-per-pixel");
+    }
+
+    if (options.read_gap < 0) {
+        throw app::Error("Read gap must not be negative");
+    }
+
+    if (options.cache_line <= 0) {
+        throw app::Error("Cache line size must be positive");
+    }
+
+    if (!options.frequency_paths.empty() && (options.bitstream || !options.tile_size.empty())) {
+        throw app::Error("Frequency ordering cannot be combined with bitstream packing or tiles");
+    }
+
+    if (options.align < 0 || (options.align & (options.align - 1)) != 0) {
+        throw app::Error("Alignment must be a power of 2");
+    }
+
+    if (options.row_align != 1 && options.row_align != 2 && options.row_align != 4 && options.row_align != 8) {
+        throw app::Error("Row alignment must be 1, 2, 4 or 8 bytes");
+    }
+
+    if (options.glyph_align < 1 || (options.glyph_align & (options.glyph_align - 1)) != 0) {
+        throw app::Error("Glyph alignment must be a power of 2");
+    }
+
+    if (!options.word_output.empty() && options.word_output != "le" && options.word_output != "be") {
+        throw app::Error("Word output must be le or be");
+    }
+
+    if (options.raster_type == "page" && options.bitstream) {
+        throw app::Error("Page raster type cannot be combined with bitstream packing");
+    }
+
+    if (!options.tile_size.empty() && (options.bitstream || !options.external_path.empty() ||
+                                       !options.hot_section.empty() || !options.hot_char_set_path.empty())) {
+        throw app::Error("Tiles cannot be combined with bitstream packing, external or hot pixel data");
+    }
+
+    if (options.bitstream && (options.row_align > 1 || options.glyph_align > 1 || !options.external_path.empty() ||
+                              !options.hot_section.empty() || !options.hot_char_set_path.empty())) {
+        throw app::Error("Bitstream packing cannot be combined with alignment, external or hot pixel data");
+    }
+
+    if ((!options.hot_section.empty() || !options.hot_char_set_path.empty()) && !options.external_path.empty()) {
+        throw app::Error("Hot glyphs cannot be split from external pixel data");
+    }
+
+    // both move pixel data out of codepoint order, which the monospace range table cannot describe
+    if (options.monospace && (!options.hot_section.empty() || !options.hot_char_set_path.empty() ||
+                              !options.frequency_paths.empty())) {
+        throw app::Error("Monospace layout cannot be combined with hot pixel data or frequency ordering");
+    }
+
+    if (!options.color_format.empty()) {
+        app::color_depth(options.color_format);
+
+        if (options.raster_type == "page" || options.bitstream) {
+            throw app::Error("Color formats cannot be combined with page raster type or bitstream packing");
+        }
+
+        if (options.color_endian != "le" && options.color_endian != "be") {
+            throw app::Error("Color byte order must be le or be");
+        }
+
+        // both are read as native words, so a file can only suit one byte order
+        if (!options.word_output.empty() && options.color_format != "rgb888" &&
+            options.word_output != options.color_endian) {
+            throw app::Error("Color byte order must match word output");
+        }
+    } else if (!options.fg_color.empty() || !options.bg_color.empty() || !options.palette.empty()) {
+        throw app::Error("Colors require a color format");
+    }
+
+    if (!options.palette.empty() && (!options.fg_color.empty() || !options.bg_color.empty())) {
+        throw app::Error("Palette cannot be combined with foreground or background colors");
+    }
+
+    if (options.planar && (options.bitstream || !options.color_format.empty())) {
+        throw app::Error("Planar output cannot be combined with bitstream packing or color formats");
+    }
+
+    if (options.auto_depth > 127) {
+        throw app::Error("Auto depth tolerance must be 0 to 127");
+    }
+
+    if ((options.dither || options.optimal_levels) && !options.color_format.empty()) {
+        throw app::Error("Dithering and optimal levels cannot be combined with color formats");
+    }
+
+    if (options.gamma <= 0.0) {
+        throw app::Error("Gamma must be greater than 0");
+    }
+}
+
+
 static void parse_args(int& argc, char** argv, app::Options& options) {
     app::ArgParser p("[FONT PATH] [OUTPUT PATH]",
                      "Convert font glyphs into bitmap images embeddable in C source code.",
                      "If no character set file is specified, a default character set consisting of ASCII\n"
                      "codes 32-126 (inclusive) will be used. If a character set filename ends in .hex it will\n"
                      "be interpreted as a line delimited list of hexadecimal codepoints, otherwise it must be\n"
-                     "a UTF-8 encoded text file containing the characters to use.");
+                     "a UTF-8 encoded text file containing the characters to use. In .hex files, a line of the\n"
+                     "form '@depth N' sets the pixel depth of the codepoints that follow it (0 = --depth).");
 
     try {
         p.option(options.size, "PIXELS", 's', "size", fmt::format("Font size (default = {})", options.size));
@@ -206,7 +377,7 @@ static void parse_args(int& argc, char** argv, app::Options& options) {
         p.option(options.symbol_name, "NAME", 'y', "symbol", "Symbol name for font2c_face_t object");
 
         p.option(options.pixel_depth, "BPP", 'd', "depth",
-                 fmt::format("Pixel depth (must be 1, 2, 4 or 8, default = {})", options.pixel_depth));
+                 fmt::format("Pixel depth (must be 1 to 8, default = {})", options.pixel_depth));
 
         p.option(options.msb_first, 'm', "msb-first", "Pack most-significant bits first");
 
@@ -218,15 +389,99 @@ static void parse_args(int& argc, char** argv, app::Options& options) {
 
         p.option(options.center_adjust, "PIXELS", 'j', "center-adj", "Number of pixels to adjust font center line by");
 
+        p.option(options.monospace, 'M', "monospace", "Pad glyphs to a common box and advance (fixed-pitch output)");
+
+        p.option(options.kerning, 'k', "kerning", "Include kerning pairs from font's kerning table");
+
+        p.option(options.external_path, "PATH", 'x', "external",
+                 "Write pixel data to a separate binary file for external storage");
+
+        p.option(options.reference_text, "TEXT", 't', "reference-text",
+                 "Report number of external reads needed to render TEXT");
+
+        p.option(options.read_gap, "BYTES", 'g', "read-gap",
+                 fmt::format("Largest gap bridged when coalescing external reads (default = {})", options.read_gap));
+
+        p.option(options.section, "NAME", "section", "Linker section to place tables in");
+
+        p.option(options.hot_section, "NAME", "hot-section", "Linker section to place hot glyph pixels in");
+
+        p.option(options.hot_char_set_path, "PATH", "hot-char-set",
+                 "Path to character set file of hot glyphs (default = ASCII codes 32-126)");
+
+        p.option(options.align, "BYTES", "align", "Alignment of tables in bytes (must be a power of 2)");
+
+        p.option(options.row_align, "BYTES", "row-align",
+                 fmt::format("Pad each bitmap row to a multiple of BYTES (1, 2, 4 or 8, default = {})",
+                             options.row_align));
+
+        p.option(options.glyph_align, "BYTES", "glyph-align",
+                 fmt::format("Align each glyph's bitmap to BYTES (must be a power of 2, default = {})",
+                             options.glyph_align));
+
+        p.option(options.word_output, "ENDIAN", "word-output",
+                 "Emit pixel data as uint32_t words in the target's byte order (le or be)");
+
+        p.option(options.bitstream, 'b', "bitstream", "Pack pixels as a continuous bitstream without row padding");
+
+        p.option(options.tile_size, "SIZE", "tile", "Split glyphs into deduplicated tiles (e.g. 8 or 8x16)");
+
+        p.option(options.color_format, "FORMAT", "color-format", "Emit pre-blended colors (rgb565, rgb888, argb8888)");
+
+        p.option(options.color_endian, "ENDIAN", "color-endian",
+                 fmt::format("Byte order of RGB565 and ARGB8888 pixels (le or be, default = {})",
+                             options.color_endian));
+
+        p.option(options.fg_color, "COLOR", "fg", "Foreground color of pre-blended pixels (default = FFFFFF)");
+
+        p.option(options.bg_color, "COLOR", "bg", "Background color of pre-blended pixels (default = 000000)");
+
+        p.option(options.palette, "COLORS", "palette", "Comma-separated colors from background to foreground");
+
+        p.option(options.gamma, "GAMMA", "gamma",
+                 fmt::format("Gamma used to blend pre-blended pixels (default = {:.1f})", options.gamma));
+
+        p.option(options.planar, 'P', "planar", "Store each glyph as separate 1bpp bit-planes");
+
+        p.option(options.auto_depth, "TOLERANCE", "auto-depth",
+                 "Store glyphs at 1bpp if coverage stays within TOLERANCE of 0 or 255");
+
+        p.option(options.dither, "dither", "Diffuse quantization error across each glyph (Floyd-Steinberg)");
+
+        p.option(options.optimal_levels, "optimal-levels",
+                 "Fit quantization levels to the font's coverage and emit them as a lookup table");
+
+        p.option(options.variants, "SPEC", "variant",
+                 "Also write DEPTH:RASTER:BITORDER:SYMBOL:PATH from the same glyphs (repeatable)");
+
+        p.option(options.corpus_paths, "PATH", "corpus",
+                 "Only include characters used by string literals in PATH (source, .po or .json, repeatable)");
+
+        p.option(options.include_ranges, "RANGES", "include",
+                 "Always include codepoints or ranges, e.g. 20-7E,B0,U+2013..U+2014 (with --corpus)");
+
+        p.option(options.locales, "NAME:PATHS", "locale",
+                 "Write glyphs only used by locale NAME's corpus files PATHS to their own shard (repeatable)");
+
+        p.option(options.frequency_paths, "PATH", "frequency",
+                 "Order pixel data by how often characters occur in corpus PATH (source, .po, .json or .txt, repeatable)");
+
+        p.option(options.cache_line, "BYTES", "cache-line",
+                 fmt::format("Cache line size for the --frequency footprint report (default = {})", options.cache_line));
+
         p.parse(argc, argv);
+        check_layout(options);
+
+        if (!options.include_ranges.empty() && options.corpus_paths.empty()) {
+            throw app::Error("Include ranges require a corpus");
+        }
 
-        if (options.pixel_depth != 1 && options.pixel_depth != 2 && options.pixel_depth != 4 &&
-            options.pixel_depth != 8) {
-            throw app::Error("Pixel depth must be 1, 2, 4 or 8 bits-per-pixel");
+        if (!options.locales.empty() && !options.variants.empty()) {
+            throw app::Error("Locale shards cannot be combined with variants");
         }
 
-        if (options.pixel_depth == 1) {
-            options.antialiasing = false;
+        if (!options.variants.empty() && (!options.color_format.empty() || !options.external_path.empty())) {
+            throw app::Error("Variants cannot be combined with color formats or external pixel data");
         }
     } catch (app::ArgParserHelpException&) {
         p.display_help();
@@ -246,6 +501,363 @@ static void parse_args(int& argc, char** argv, app::Options& options) {
 }
 
 
+static app::Rectangle grid_align(const app::Rectangle& box, int cell_width, int cell_height) {
+    auto floor_cell = [](int v, int cell) {
+        return v - (((v % cell) + cell) % cell);
+    };
+
+    int x1 = floor_cell(box.x1, cell_width);
+    int y1 = floor_cell(box.y1, cell_height);
+    int x2 = -floor_cell(-box.x2, cell_width);
+    int y2 = -floor_cell(-box.y2, cell_height);
+
+    return {x1, y1, x2 - x1, y2 - y1};
+}
+
+
+static std::vector<uint32_t> build_palette(const app::Options& options) {
+    std::vector<uint32_t> palette;
+
+    if (!options.palette.empty()) {
+        std::istringstream stream(options.palette);
+        std::string color;
+
+        while (std::getline(stream, color, ',')) {
+            palette.push_back(app::color_parse(color));
+        }
+
+        if (palette.size() < 2 || palette.size() > 256) {
+            throw app::Error("Palette must list 2 to 256 colors");
+        }
+    } else {
+        uint32_t fg = app::color_parse(options.fg_color.empty() ? "FFFFFF" : options.fg_color);
+        uint32_t bg = app::color_parse(options.bg_color.empty() ? "000000" : options.bg_color);
+
+        palette = app::color_ramp(fg, bg, options.gamma, 1 << options.pixel_depth);
+    }
+
+    for (auto& color: palette) {
+        color = app::color_convert(color, options.color_format);
+    }
+
+    return palette;
+}
+
+
+static void parse_tile_size(const std::string& size, int& width, int& height) {
+    int n = std::sscanf(size.c_str(), "%dx%d", &width, &height);
+
+    if (n == 1) {
+        height = width;
+    } else if (n != 2) {
+        throw app::Error("Invalid tile size: {}", size);
+    }
+
+    if (width < 1 || height < 1 || width > 255 || height > 255) {
+        throw app::Error("Tile dimensions must be 1 to 255 pixels");
+    }
+}
+
+
+static bool is_binary(const app::Glyph& glyph, int tolerance) {
+    for (int y = 0; y < glyph.height(); y++) {
+        for (int x = 0; x < glyph.width(); x++) {
+            int value = get_glyph_pixel(glyph, x, y);
+
+            if (value > tolerance && value < (255 - tolerance)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+
+static void measure_char_set(app::Font& font, const app::CharSet& char_set, const app::Options& options,
+                             app::Rectangle& box, int& x_advance) {
+    box = app::Rectangle();
+    x_advance = 0;
+
+    for (auto codepoint: char_set) {
+        try {
+            app::Glyph glyph(font, codepoint, options.antialiasing, options.no_hinting);
+            box.unite(glyph.bounds());
+            x_advance = std::max(x_advance, glyph.x_advance());
+        } catch (app::GlyphError&) {
+            // ignore, reported when glyphs are added to output model
+        }
+    }
+}
+
+
+static app::Histogram measure_coverage(app::Font& font, const app::CharSet& char_set, const app::DepthMap& depths,
+                                       const app::Options& options) {
+    app::Histogram histogram = {};
+
+    for (auto codepoint: char_set) {
+        // only glyphs stored at the font's own depth are quantized to its levels
+        if (app::depth_lookup(depths, codepoint, options.pixel_depth) != options.pixel_depth) {
+            continue;
+        }
+
+        try {
+            app::Glyph glyph(font, codepoint, options.antialiasing, options.no_hinting);
+
+            for (int y = 0; y < glyph.height(); y++) {
+                for (int x = 0; x < glyph.width(); x++) {
+                    histogram[get_glyph_pixel(glyph, x, y)]++;
+                }
+            }
+        } catch (app::GlyphError&) {
+            // ignore, reported when glyphs are added to output model
+        }
+    }
+
+    return histogram;
+}
+
+
+static uint32_t estimate_glyph_size(app::Font& font, char32_t codepoint, const app::Options& options) {
+    int depth = options.color_format.empty() ? options.pixel_depth : app::color_depth(options.color_format);
+
+    try {
+        app::Glyph glyph(font, codepoint, options.antialiasing, options.no_hinting);
+        bool rows = options.raster_type[0] == 'l' || options.raster_type[0] == 'r';
+        int line_length = rows ? glyph.width() : glyph.height();
+        int n_lines = rows ? glyph.height() : glyph.width();
+
+        // bitmap plus lookup table entry, ignoring alignment and padding
+        return static_cast<uint32_t>((((line_length * depth) + 7) / 8) * n_lines) +
+               (options.monospace ? 0 : sizeof(font2c_glyph_t));
+    } catch (app::GlyphError&) {
+        return 0;
+    }
+}
+
+
+static app::CharSet load_corpus(app::Font& font, const app::CharSet& configured, const app::Options& options) {
+    app::CharSet corpus;
+    size_t n_unused = 0;
+    size_t n_added = 0;
+    uint64_t saved = 0;
+
+    for (const auto& path: options.corpus_paths) {
+        app::corpus_scan(path, corpus);
+    }
+
+    app::char_set_add_ranges(corpus, options.include_ranges);
+
+    for (auto codepoint: configured) {
+        if (corpus.count(codepoint) == 0) {
+            n_unused++;
+            saved += estimate_glyph_size(font, codepoint, options);
+        }
+    }
+
+    for (auto codepoint: corpus) {
+        n_added += configured.count(codepoint) ? 0 : 1;
+    }
+
+    fmt::print("Corpus uses {} characters: {} configured glyphs dropped (about {} bytes saved), {} added\n",
+               corpus.size(), n_unused, saved, n_added);
+
+    return corpus;
+}
+
+
+static app::Options parse_variant(const app::Options& options, const std::string& spec, std::string& path) {
+    app::Options variant = options;
+    std::string fields[4];
+    size_t start = 0;
+
+    // path is everything after the fourth colon, so it may contain colons of its own
+    for (auto& field: fields) {
+        size_t end = spec.find(':', start);
+
+        if (end == std::string::npos) {
+            throw app::Error("Invalid variant (expected DEPTH:RASTER:BITORDER:SYMBOL:PATH): {}", spec);
+        }
+
+        field = spec.substr(start, end - start);
+        start = end + 1;
+    }
+
+    path = spec.substr(start);
+
+    if (path.empty()) {
+        throw app::Error("Variant has no output path: {}", spec);
+    }
+
+    if (!fields[0].empty()) {
+        auto result = std::from_chars(fields[0].data(), fields[0].data() + fields[0].size(), variant.pixel_depth);
+
+        if (result.ec != std::errc() || result.ptr != (fields[0].data() + fields[0].size())) {
+            throw app::Error("Invalid variant depth: {}", fields[0]);
+        }
+    }
+
+    if (!fields[1].empty()) {
+        variant.raster_type = fields[1];
+    }
+
+    if (fields[2] == "msb") {
+        variant.msb_first = true;
+    } else if (fields[2] == "lsb") {
+        variant.msb_first = false;
+    } else if (!fields[2].empty()) {
+        throw app::Error("Variant bit order must be msb or lsb: {}", fields[2]);
+    }
+
+    if (!fields[3].empty()) {
+        variant.symbol_name = fields[3];
+    }
+
+    check_layout(variant);
+
+    return variant;
+}
+
+
+static std::string shard_path(const std::string& path, const std::string& name) {
+    std::filesystem::path p(path);
+
+    return (p.parent_path() / (p.stem().string() + "_" + name + p.extension().string())).string();
+}
+
+
+static void add_locale_shards(std::vector<Target>& targets, const std::string& path) {
+    const app::Options options = targets.front().options;
+    std::vector<std::pair<std::string, app::CharSet>> locales;
+    std::optional<app::CharSet> common;
+
+    for (const auto& spec: options.locales) {
+        size_t colon = spec.find(':');
+        std::string name = spec.substr(0, colon);
+        std::istringstream paths((colon == std::string::npos) ? std::string() : spec.substr(colon + 1));
+        std::string corpus_path;
+        app::CharSet char_set;
+
+        if (name.empty() || colon == std::string::npos ||
+            !std::all_of(name.begin(), name.end(), [](char c) { return std::isalnum(c) || c == '_'; })) {
+            throw app::Error("Invalid locale (expected NAME:PATHS, NAME made of letters, digits and _): {}", spec);
+        }
+
+        while (std::getline(paths, corpus_path, ',')) {
+            app::corpus_scan(corpus_path, char_set);
+        }
+
+        if (!common) {
+            common = char_set;
+        } else {
+            common = app::char_set_intersection(*common, char_set);
+        }
+
+        locales.emplace_back(name, std::move(char_set));
+    }
+
+    // characters every locale uses join the base shard, the rest go in per-locale shards that fall back to it
+    targets.front().char_set = app::char_set_union(targets.front().char_set, *common);
+
+    for (const auto& [name, char_set]: locales) {
+        Target shard{options, shard_path(path, name)};
+
+        shard.options.symbol_name = options.symbol_name + "_" + name;
+
+        if (!options.external_path.empty()) {
+            shard.options.external_path = shard_path(options.external_path, name);
+        }
+
+        shard.char_set = app::char_set_difference(char_set, targets.front().char_set);
+
+        targets.push_back(std::move(shard));
+    }
+}
+
+
+static void report_locale_shards(const std::vector<Target>& targets) {
+    bool external = !targets.front().options.external_path.empty();
+    size_t base_size = targets.front().output_model->memory_size(external);
+    size_t total_size = base_size;
+    size_t largest = 0;
+
+    fmt::print("Base shard {}: {} glyphs, {} bytes\n", targets.front().options.symbol_name,
+               targets.front().char_set.size(), base_size);
+
+    for (size_t i = 1; i < targets.size(); i++) {
+        size_t size = targets[i].output_model->memory_size(external);
+
+        fmt::print("Locale shard {}: {} glyphs, {} bytes\n", targets[i].options.symbol_name,
+                   targets[i].char_set.size(), size);
+        total_size += size;
+        largest = std::max(largest, size);
+    }
+
+    fmt::print("Base plus largest locale shard: {} bytes, against {} bytes for every shard\n", base_size + largest,
+               total_size);
+}
+
+
+static void report_missing(const app::CharSet& missing) {
+    static constexpr size_t MAX_LISTED = 8;
+    const auto& ranges = missing.ranges();
+    std::string list;
+
+    if (missing.empty()) {
+        return;
+    }
+
+    for (size_t i = 0; i < ranges.size() && i < MAX_LISTED; i++) {
+        list += (i > 0) ? ", " : "";
+        list += (ranges[i].first == ranges[i].last) ?
+                fmt::format("U+{:04X}", static_cast<uint32_t>(ranges[i].first)) :
+                fmt::format("U+{:04X}-U+{:04X}", static_cast<uint32_t>(ranges[i].first),
+                            static_cast<uint32_t>(ranges[i].last));
+    }
+
+    if (ranges.size() > MAX_LISTED) {
+        list += fmt::format(" and {} more ranges", ranges.size() - MAX_LISTED);
+    }
+
+    fmt::print(stderr, "Warning: Font has no glyphs for {} codepoints: {}\n", missing.size(), list);
+}
+
+
+static std::vector<Render> render_batch(app::Font& font, const std::vector<Target>& targets,
+                                        const app::DepthMap& depths, const char32_t* codepoints, size_t n) {
+    std::vector<Render> renders(n);
+    std::vector<std::pair<unsigned int, size_t>> order;
+
+    // glyphs are loaded in glyph index order, which is usually the order their outlines are stored in the font file
+    for (size_t i = 0; i < n; i++) {
+        order.emplace_back(font.char_index(codepoints[i]), i);
+    }
+
+    std::sort(order.begin(), order.end());
+
+    for (const auto& [index, i]: order) {
+        for (const auto& target: targets) {
+            const app::Options& target_options = target.options;
+            int depth = app::depth_lookup(depths, codepoints[i], target_options.pixel_depth);
+            bool antialiased = target_options.antialiasing && depth > 1;
+            auto& render = renders[i].glyphs[antialiased];
+
+            if (render || !renders[i].error.empty() || target.char_set.count(codepoints[i]) == 0) {
+                continue;
+            }
+
+            try {
+                render.emplace(font, codepoints[i], antialiased, target_options.no_hinting);
+            } catch (app::GlyphError& e) {
+                renders[i].error = e.what();
+            }
+        }
+    }
+
+    return renders;
+}
+
+
 static std::string reconstruct_command_line(int argc, char* argv[]) {
     std::string cmd_line;
 
@@ -272,6 +884,9 @@ int main(int argc, char* argv[]) {
     try {
         app::Options options;
         app::CharSet char_set;
+        app::DepthMap depths;
+        app::CharCounts frequencies;
+        std::vector<Target> targets;
 
         parse_args(argc, argv, options);
 
@@ -286,33 +901,274 @@ int main(int argc, char* argv[]) {
         if (options.char_set_path.empty()) {
             char_set = app::char_set_default();
         } else {
-            char_set = app::char_set_load(options.char_set_path);
+            char_set = app::char_set_load(options.char_set_path, &depths);
         }
 
-        auto rm = rasterizer_map();
-        auto ri = rm.find(options.raster_type);
+        bool mixed_depth = (options.auto_depth >= 0) || !depths.empty();
+        app::Font font(argv[1], options.size);
 
-        if (ri == rm.end()) {
-            throw app::Error("Unrecognized raster type: {}", options.raster_type);
+        if (!options.corpus_paths.empty()) {
+            char_set = load_corpus(font, char_set, options);
         }
 
-        app::Font font(argv[1], options.size);
-        app::OutputModel output_model(options.pixel_depth, options.msb_first, ri->second.func, cmd_line);
+        for (const auto& path: options.frequency_paths) {
+            app::corpus_count(path, frequencies);
+        }
 
-        for (auto codepoint: char_set) {
-            try {
-                app::Glyph glyph(font, codepoint, options.antialiasing, options.no_hinting);
-                output_model.add_glyph(glyph);
-            } catch (app::GlyphError& e) {
-                fmt::print(stderr, "Warning: {}\n", e.what());
+        // the main output (or base shard) comes first, followed by any variants or locale shards sharing its glyphs
+        targets.push_back({options, argv[2], char_set});
+
+        for (const auto& spec: options.variants) {
+            std::string path;
+            app::Options variant = parse_variant(options, spec, path);
+
+            targets.push_back({variant, path, char_set});
+        }
+
+        if (!options.locales.empty()) {
+            add_locale_shards(targets, argv[2]);
+        }
+
+        for (size_t i = 1; i < targets.size(); i++) {
+            char_set = app::char_set_union(char_set, targets[i].char_set);
+        }
+
+        // codepoints missing from the font's cmap are reported together rather than failing one at a time
+        app::CharSet covered = app::char_set_intersection(char_set, font.coverage());
+
+        report_missing(app::char_set_difference(char_set, covered));
+        char_set = std::move(covered);
+
+        for (auto& target: targets) {
+            target.char_set = app::char_set_intersection(target.char_set, char_set);
+        }
+
+        bool color = !options.color_format.empty();
+        std::map<bool, std::pair<app::Rectangle, int>> mono_metrics;
+        std::map<std::pair<bool, int>, app::Histogram> histograms;
+
+        for (auto& target: targets) {
+            app::Options& target_options = target.options;
+
+            if (target_options.pixel_depth == 1) {
+                target_options.antialiasing = false;
+            }
+
+            if (mixed_depth && (options.monospace || !options.tile_size.empty() || !options.color_format.empty() ||
+                                options.planar || target_options.raster_type == "page")) {
+                throw app::Error("Per-glyph depths cannot be combined with monospace, tiles, color formats, "
+                                 "planar output or page raster type");
+            }
+
+            target.output_model = std::make_unique<app::OutputModel>(
+                    color ? app::color_depth(options.color_format) : target_options.pixel_depth,
+                    target_options.msb_first, rasterizer_map().at(target_options.raster_type).func, cmd_line);
+
+            app::OutputModel& output_model = *target.output_model;
+
+            output_model.set_alignment(options.row_align, options.glyph_align);
+            output_model.set_bitstream(options.bitstream);
+            output_model.set_planar(options.planar);
+
+            if (!options.locales.empty() && &target != &targets.front()) {
+                output_model.set_fallback(options.symbol_name);
+            }
+
+            if (color) {
+                // rgb888 is always stored R, G, B; other formats are native words in the target's byte order
+                output_model.set_palette(build_palette(target_options),
+                                         options.color_format == "rgb888" || options.color_endian == "be");
+            } else {
+                if (options.optimal_levels) {
+                    // histogram only depends on depth when some glyphs are stored at other depths
+                    auto key = std::make_pair(target_options.antialiasing,
+                                              depths.empty() ? 0 : target_options.pixel_depth);
+                    auto i = histograms.find(key);
+
+                    if (i == histograms.end()) {
+                        i = histograms.emplace(key, measure_coverage(font, char_set, depths, target_options)).first;
+                    }
+
+                    target.levels = app::quantize_levels(i->second, target_options.pixel_depth);
+                }
+
+                output_model.set_quantization(target.levels, options.dither);
+            }
+
+            // glyphs are padded to a grid of whole pages or tiles, anchored at the origin and baseline
+            target.cell_width = 1;
+            target.cell_height = (target_options.raster_type == "page") ? output_model.page_height() : 1;
+
+            if (!options.tile_size.empty()) {
+                int tile_width;
+                int tile_height;
+
+                parse_tile_size(options.tile_size, tile_width, tile_height);
+
+                if ((tile_height % target.cell_height) != 0) {
+                    throw app::Error("Tile height must be a multiple of the page height ({} pixels)",
+                                     target.cell_height);
+                }
+
+                target.cell_width = tile_width;
+                target.cell_height = tile_height;
+                output_model.set_tiles(tile_width, tile_height);
+            }
+
+            if (options.monospace) {
+                auto i = mono_metrics.find(target_options.antialiasing);
+
+                if (i == mono_metrics.end()) {
+                    app::Rectangle box;
+                    int x_advance;
+
+                    measure_char_set(font, char_set, target_options, box, x_advance);
+                    i = mono_metrics.emplace(target_options.antialiasing, std::make_pair(box, x_advance)).first;
+                }
+
+                target.mono_box = i->second.first;
+                target.mono_x_advance = i->second.second;
+
+                if (target.cell_width > 1 || target.cell_height > 1) {
+                    target.mono_box = grid_align(target.mono_box, target.cell_width, target.cell_height);
+                }
+            }
+        }
+
+        std::vector<char32_t> codepoints(char_set.begin(), char_set.end());
+        std::vector<Render> renders;
+
+        for (size_t i = 0; i < codepoints.size(); i++) {
+            char32_t codepoint = codepoints[i];
+            bool warned = false;
+
+            // each glyph is rasterized once per anti-aliasing mode, a batch at a time, and copied into every target
+            if ((i % RENDER_BATCH_SIZE) == 0) {
+                renders = render_batch(font, targets, depths, codepoints.data() + i,
+                                       std::min(RENDER_BATCH_SIZE, codepoints.size() - i));
+            }
+
+            for (auto& target: targets) {
+                const app::Options& target_options = target.options;
+                bool grid = (target.cell_width > 1 || target.cell_height > 1);
+
+                if (target.char_set.count(codepoint) == 0) {
+                    continue;
+                }
+
+                try {
+                    const Render& rendered = renders[i % RENDER_BATCH_SIZE];
+                    int depth = app::depth_lookup(depths, codepoint, target_options.pixel_depth);
+                    bool antialiased = target_options.antialiasing && depth > 1;
+                    const auto& render = rendered.glyphs[antialiased];
+
+                    if (!render) {
+                        throw app::GlyphError(rendered.error);
+                    }
+
+                    app::Glyph glyph = render->crop(render->bounds());
+
+                    if (target_options.auto_depth >= 0 && depth > 1 && is_binary(glyph, target_options.auto_depth)) {
+                        depth = 1;
+                    }
+
+                    if (target_options.monospace) {
+                        glyph.pad(target.mono_box);
+                        glyph.set_x_advance(target.mono_x_advance);
+                    } else if (grid && !glyph.bounds().empty()) {
+                        glyph.pad(grid_align(glyph.bounds(), target.cell_width, target.cell_height));
+                    }
+
+                    target.output_model->add_glyph(glyph, mixed_depth ? depth : 0);
+                } catch (app::GlyphError& e) {
+                    if (!warned) {
+                        fmt::print(stderr, "Warning: {}\n", e.what());
+                        warned = true;
+                    }
+                }
+            }
+        }
+
+        if (options.kerning && !font.has_kerning()) {
+            fmt::print(stderr, "Warning: Font has no kerning table\n");
+        }
+
+        if (!options.locales.empty()) {
+            int ascent = 0;
+            int descent = 0;
+            int height = 0;
+
+            for (const auto& target: targets) {
+                ascent = std::max(ascent, target.output_model->line_ascent());
+                descent = std::max(descent, target.output_model->line_descent());
+                height = std::max(height, target.output_model->line_height());
+            }
+
+            for (auto& target: targets) {
+                target.output_model->set_line_metrics(ascent, descent, height);
+            }
+        }
+
+        for (auto& target: targets) {
+            app::OutputModel& output_model = *target.output_model;
+
+            if (!frequencies.empty()) {
+                uint32_t line_size = static_cast<uint32_t>(options.cache_line);
+                auto before = output_model.cache_footprint(frequencies, line_size);
+
+                output_model.order_by_frequency(frequencies);
+
+                auto after = output_model.cache_footprint(frequencies, line_size);
+
+                fmt::print("{}: corpus touches {} {}-byte cache lines ({} before frequency ordering), "
+                           "90% of its text {} ({} before)\n", target.path, after.lines, line_size, before.lines,
+                           after.hot_lines, before.hot_lines);
             }
+
+            if (!options.hot_section.empty() || !options.hot_char_set_path.empty()) {
+                if (options.hot_char_set_path.empty()) {
+                    output_model.split_hot(app::char_set_default());
+                } else {
+                    output_model.split_hot(app::char_set_load(options.hot_char_set_path));
+                }
+            }
+
+            if (options.kerning) {
+                output_model.add_kerning(font);
+            }
+
+            output_model.write(target.path, argv[1], target.options);
+
+            if (!target.options.external_path.empty()) {
+                output_model.write_pixels(target.options.external_path);
+            }
+
+            if (options.dither || options.optimal_levels) {
+                fmt::print("{}: quantization PSNR against 8-bit coverage: {:.2f} dB ({:.2f} dB blurred)\n",
+                           target.path, output_model.psnr(), output_model.psnr(true));
+            }
+        }
+
+        const Target& main_target = targets.front();
+
+        if (!options.locales.empty()) {
+            report_locale_shards(targets);
         }
 
-        output_model.write(argv[2], argv[1], options);
+        if (!options.reference_text.empty()) {
+            auto text = app::utf8_decode(options.reference_text);
+            auto reads = main_target.output_model->count_reads(text, static_cast<uint32_t>(options.read_gap));
+
+            fmt::print("Reference text needs {} reads ({} uncoalesced, {} byte gap)\n", reads.coalesced,
+                       reads.uncoalesced, options.read_gap);
+        }
 
         if (!options.preview_path.empty()) {
-            app::preview_generate(options.preview_path, font, char_set, options.pixel_depth, options.antialiasing,
-                                  options.no_hinting);
+            const app::Options& main_options = main_target.options;
+
+            app::preview_generate(options.preview_path, font, char_set, main_options.pixel_depth,
+                                  main_options.antialiasing, main_options.no_hinting, main_target.levels,
+                                  options.dither);
         }
 
         exit_code = EXIT_SUCCESS;
@@ -0,0 +1,84 @@
+/*
+ * font2c - Command-line utility for converting font glyphs into bitmap images
+ * embeddable in C source code.
+ *
+ * https://github.com/mattbucknall/font2c
+ *
+ * Copyright (C) 2022 Matthew T. Bucknall
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <font2c-types.h>
+
+
+#define SURFACE_WIDTH   2048
+#define SURFACE_HEIGHT  64
+#define ITERATIONS      20000
+
+
+extern const font2c_font_t text_font;
+extern const font2c_font_t mono_font;
+extern const font2c_font_t mono_font_msb;
+extern const font2c_font_t mono_font_large;
+
+static const char SENTENCE[] = "The quick brown fox jumps over the lazy dog, while AVA and Tom wait.";
+
+static uint8_t pixels[SURFACE_HEIGHT * SURFACE_WIDTH * 2];
+static volatile uint8_t sink;
+
+
+static double now(void) {
+    struct timespec ts;
+
+    timespec_get(&ts, TIME_UTC);
+
+    return (double) ts.tv_sec + ((double) ts.tv_nsec * 1e-9);
+}
+
+
+static void bench(const char* name, const font2c_font_t* font, font2c_format_t format, uint32_t pitch) {
+    font2c_surface_t surface;
+    size_t length = strlen(SENTENCE);
+    double glyphs = (double) length * ITERATIONS;
+    double start;
+    double seconds;
+
+    font2c_surface_init(&surface, pixels, format, SURFACE_WIDTH, SURFACE_HEIGHT, pitch);
+    start = now();
+
+    // origin steps through every sub-byte alignment of mono surfaces
+    for (int i = 0; i < ITERATIONS; i++) {
+        font2c_draw_utf8(&surface, font, i & 7, font->ascent, SENTENCE, length, (i & 8) ? 0 : 0xFFFFFF);
+    }
+
+    seconds = now() - start;
+    sink = pixels[0];
+
+    printf("%-32s %8.2f Mglyph/s %8.1f ns/glyph\n", name, glyphs / seconds / 1e6, seconds * 1e9 / glyphs);
+}
+
+
+int main(void) {
+    printf("%d x \"%s\"\n", ITERATIONS, SENTENCE);
+    bench("1bpp lsb -> mono", &mono_font, FONT2C_FORMAT_MONO, SURFACE_WIDTH / 8);
+    bench("1bpp msb -> mono", &mono_font_msb, FONT2C_FORMAT_MONO, SURFACE_WIDTH / 8);
+    bench("1bpp lsb 48px -> mono", &mono_font_large, FONT2C_FORMAT_MONO, SURFACE_WIDTH / 8);
+    bench("1bpp lsb -> gray8", &mono_font, FONT2C_FORMAT_GRAY8, SURFACE_WIDTH);
+    bench("4bpp -> gray8", &text_font, FONT2C_FORMAT_GRAY8, SURFACE_WIDTH);
+    bench("4bpp -> rgb565", &text_font, FONT2C_FORMAT_RGB565, SURFACE_WIDTH * 2);
+
+    return 0;
+}
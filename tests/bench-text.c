@@ -0,0 +1,100 @@
+/*
+ * font2c - Command-line utility for converting font glyphs into bitmap images
+ * embeddable in C source code.
+ *
+ * https://github.com/mattbucknall/font2c
+ *
+ * Copyright (C) 2022 Matthew T. Bucknall
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <font2c-types.h>
+
+
+#define PARAGRAPH_SIZE  8192
+#define ITERATIONS      2000
+
+
+extern const font2c_font_t text_font;
+extern const font2c_font_t text_font_kerned;
+
+static const char SENTENCE[] = "The quick brown fox jumps over the lazy dog, while AVA and Tom wait. ";
+
+static char paragraph[PARAGRAPH_SIZE + 1];
+static font2c_line_t lines[4096];
+static volatile int32_t sink;
+
+
+static double now(void) {
+    struct timespec ts;
+
+    timespec_get(&ts, TIME_UTC);
+
+    return (double) ts.tv_sec + ((double) ts.tv_nsec * 1e-9);
+}
+
+
+static void report(const char* name, double start) {
+    double seconds = now() - start;
+    double bytes = (double) PARAGRAPH_SIZE * ITERATIONS;
+
+    printf("%-32s %8.1f MB/s %8.2f ns/byte\n", name, bytes / seconds / 1e6, seconds * 1e9 / bytes);
+}
+
+
+static void bench_font(const font2c_font_t* font, const char* label) {
+    static const int32_t WIDTHS[] = {120, 480};
+    char name[64];
+    double start;
+
+    start = now();
+
+    for (int i = 0; i < ITERATIONS; i++) {
+        font2c_metrics_t metrics;
+
+        font2c_measure_utf8(font, paragraph, PARAGRAPH_SIZE, &metrics);
+        sink = metrics.width;
+    }
+
+    snprintf(name, sizeof(name), "measure (%s)", label);
+    report(name, start);
+
+    for (size_t w = 0; w < sizeof(WIDTHS) / sizeof(WIDTHS[0]); w++) {
+        start = now();
+
+        for (int i = 0; i < ITERATIONS; i++) {
+            sink = (int32_t) font2c_wrap_utf8(font, paragraph, PARAGRAPH_SIZE, WIDTHS[w], lines,
+                                              sizeof(lines) / sizeof(lines[0]));
+        }
+
+        snprintf(name, sizeof(name), "wrap %dpx (%s)", (int) WIDTHS[w], label);
+        report(name, start);
+    }
+}
+
+
+int main(void) {
+    // one long paragraph without newlines, so wrapping decides every line break
+    for (size_t i = 0; i < PARAGRAPH_SIZE; i++) {
+        paragraph[i] = SENTENCE[i % (sizeof(SENTENCE) - 1)];
+    }
+
+    printf("%d byte paragraph, %d iterations\n", PARAGRAPH_SIZE, ITERATIONS);
+    bench_font(&text_font, "plain");
+    bench_font(&text_font_kerned, "kerned");
+
+    return 0;
+}
@@ -0,0 +1,16 @@
+#include "include.h"
+#  pragma message("pragma")
+#error "error" \
+    "continued"
+#define TITLE "Hi"
+
+extern "C" {
+    int x;
+}
+
+extern"C++" const char* s = "Ok";
+const char* t = /* "comment" */ "yes";
+const char* a = "\x0041";
+char c = u8'"';
+int n = 1'000 + 0xFF'FF;
+const char* z = u8"Z";
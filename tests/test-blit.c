@@ -0,0 +1,324 @@
+/*
+ * font2c - Command-line utility for converting font glyphs into bitmap images
+ * embeddable in C source code.
+ *
+ * https://github.com/mattbucknall/font2c
+ *
+ * Copyright (C) 2022 Matthew T. Bucknall
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <string.h>
+
+#include "test.h"
+#include "blit-fonts.h"
+
+
+typedef struct {
+    const font2c_font_t* font;
+    const font2c_font_t* reference;
+    const char* name;
+} blit_font_t;
+
+
+// glyphs are drawn onto surfaces a little larger than themselves, at most this big
+#define MAX_SURFACE_WIDTH   128
+#define MAX_SURFACE_HEIGHT  96
+
+
+static const blit_font_t blit_fonts[] = {
+    BLIT_FONTS
+};
+
+
+static uint8_t surface_pixels[MAX_SURFACE_HEIGHT * MAX_SURFACE_WIDTH];
+
+
+// reference glyph, decoded here rather than by the runtime so it checks the runtime independently
+typedef struct {
+    font2c_glyph_t glyph;
+    const uint8_t* data;
+    uint32_t stride;
+    uint8_t depth;
+} reference_t;
+
+
+static void reference_init(reference_t* reference, const font2c_font_t* font, uint32_t index) {
+    font2c_glyph_at(font, index, &reference->glyph);
+    reference->data = font2c_glyph_pixels(font, &reference->glyph);
+    reference->stride = font2c_glyph_stride(font, &reference->glyph);
+    reference->depth = font->depth;
+}
+
+
+// coverage test's glyph is expected to hold at (x, y) of its bitmap, 8bpp references being truncated to
+// test's depth as the generator does
+static uint8_t expected_at(const blit_font_t* test, const font2c_glyph_t* glyph, const reference_t* reference,
+                           int32_t x, int32_t y) {
+    int32_t rx = x + glyph->x_bearing - reference->glyph.x_bearing;
+    int32_t ry = y - glyph->y_bearing + reference->glyph.y_bearing;
+    uint8_t value;
+
+    if ( rx < 0 || ry < 0 || rx >= reference->glyph.width || ry >= reference->glyph.height ) {
+        return 0;
+    }
+
+    if ( reference->depth == 1 ) {
+        // left-to-right, top-to-bottom and most-significant bit first
+        return (reference->data[((uint32_t) ry * reference->stride) + ((uint32_t) rx >> 3)] & (0x80 >> (rx & 7))) ?
+               0xFF : 0x00;
+    }
+
+    value = reference->data[((uint32_t) ry * reference->stride) + (uint32_t) rx];
+
+    return font2c_expand((uint32_t) value >> (8 - test->font->depth), test->font->depth);
+}
+
+
+// draws glyph with its bitmap's top-left corner at (gx, gy) on a width x height surface clipped at clip_x2
+// and compares every surface pixel, padding included, with reference, returning false after reporting first
+// mismatch
+static bool check_blit(const blit_font_t* test, const font2c_glyph_t* glyph, const reference_t* reference,
+                       font2c_format_t format, int32_t width, int32_t height, int32_t clip_x2, int32_t gx,
+                       int32_t gy, uint32_t color) {
+    uint32_t pitch = (format == FONT2C_FORMAT_MONO) ? (uint32_t) (width + 7) / 8 : (uint32_t) width;
+    int32_t row_pixels = (format == FONT2C_FORMAT_MONO) ? (int32_t) pitch * 8 : width;
+    font2c_surface_t surface;
+    int32_t sx;
+    int32_t sy;
+
+    // mono drawing clears pixels when color is 0, so it starts from the opposite background
+    memset(surface_pixels, (format == FONT2C_FORMAT_MONO && !color) ? 0xFF : 0x00, pitch * (uint32_t) height);
+    font2c_surface_init(&surface, surface_pixels, format, width, height, pitch);
+    font2c_surface_set_clip(&surface, 0, 0, (int16_t) clip_x2, (int16_t) height);
+    font2c_blit_glyph(&surface, test->font, glyph, gx - glyph->x_bearing, gy + glyph->y_bearing, color);
+
+    for (sy = 0; sy < height; sy++) {
+        const uint8_t* row = surface_pixels + ((uint32_t) sy * pitch);
+
+        for (sx = 0; sx < row_pixels; sx++) {
+            int32_t px = sx - gx;
+            int32_t py = sy - gy;
+            uint8_t expected = 0;
+            uint8_t actual;
+
+            if ( sx < clip_x2 && px >= 0 && py >= 0 && px < glyph->width && py < glyph->height ) {
+                expected = expected_at(test, glyph, reference, px, py);
+            }
+
+            // white on black blends to exactly the coverage of every pixel, while mono pixels are inked from
+            // 50% coverage and drawn in color over the opposite background
+            if ( format == FONT2C_FORMAT_MONO ) {
+                expected = ((expected & 0x80) != 0) == (color != 0) ? 0xFF : 0x00;
+                actual = (row[sx >> 3] & (0x80 >> (sx & 7))) ? 0xFF : 0x00;
+            } else {
+                actual = row[sx];
+            }
+
+            if ( actual != expected ) {
+                fprintf(stderr, "%s: U+%04X %s blit at (%d, %d), color %u: pixel (%d, %d) is %u, expected %u\n",
+                        test->name, (unsigned) glyph->codepoint, (format == FONT2C_FORMAT_MONO) ? "mono" : "gray",
+                        (int) gx, (int) gy, (unsigned) color, (int) sx, (int) sy, actual, expected);
+                test_failures++;
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+
+static bool check_glyph(const blit_font_t* test, const font2c_glyph_t* glyph, const reference_t* reference) {
+    static const font2c_format_t formats[] = {FONT2C_FORMAT_GRAY8, FONT2C_FORMAT_MONO};
+    int32_t width = glyph->width + 16;
+    int32_t height = glyph->height + 4;
+    size_t i;
+    int32_t gx;
+
+    for (i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+        // every sub-byte alignment, then clipped by each edge of the surface
+        for (gx = -3; gx < 9; gx++) {
+            if ( !check_blit(test, glyph, reference, formats[i], width, height, width, gx, 2, 0xFF) ) {
+                return false;
+            }
+        }
+
+        if ( !check_blit(test, glyph, reference, formats[i], width, height, width, width - 5, -2, 0xFF) ||
+             !check_blit(test, glyph, reference, formats[i], width, height, width, 11, height - 3, 0xFF) ) {
+            return false;
+        }
+
+        // clipped part way through glyph, at every sub-byte position of the clip edge
+        for (gx = 0; gx < 8; gx++) {
+            if ( !check_blit(test, glyph, reference, formats[i], width, height, 3 + gx + (glyph->width / 2), 3,
+                             2, 0xFF) ) {
+                return false;
+            }
+        }
+    }
+
+    // drawing in black clears mono pixels instead
+    for (gx = 0; gx < 8; gx++) {
+        if ( !check_blit(test, glyph, reference, FONT2C_FORMAT_MONO, width, height, width, gx, 2, 0) ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+static void check_font(const blit_font_t* test) {
+    uint32_t i;
+
+    CHECK_INT(test->font->n_glyphs, test->reference->n_glyphs);
+
+    if ( test->font->n_glyphs != test->reference->n_glyphs ) {
+        return;
+    }
+
+    for (i = 0; i < test->font->n_glyphs; i++) {
+        font2c_glyph_t glyph;
+        font2c_bitmap_t bitmap;
+        reference_t reference;
+        const font2c_glyph_t* r = &reference.glyph;
+        int32_t x;
+        int32_t y;
+
+        font2c_glyph_at(test->font, i, &glyph);
+        reference_init(&reference, test->reference, i);
+
+        // layouts may pad bitmaps (e.g. to whole pages), but never crop reference's ink
+        if ( glyph.codepoint != r->codepoint || glyph.x_advance != r->x_advance || (r->width && r->height &&
+             (r->x_bearing < glyph.x_bearing || r->y_bearing > glyph.y_bearing ||
+              r->x_bearing + r->width > glyph.x_bearing + glyph.width ||
+              r->height - r->y_bearing > glyph.height - glyph.y_bearing)) ) {
+            fprintf(stderr, "%s: metrics of glyph %u differ from reference\n", test->name, (unsigned) i);
+            test_failures++;
+            return;
+        }
+
+        font2c_bitmap_init(&bitmap, test->font, &glyph);
+
+        for (y = 0; y < glyph.height; y++) {
+            for (x = 0; x < glyph.width; x++) {
+                uint8_t actual = font2c_bitmap_get(&bitmap, x, y);
+                uint8_t expected = expected_at(test, &glyph, &reference, x, y);
+
+                if ( actual != expected ) {
+                    fprintf(stderr, "%s: U+%04X pixel (%d, %d) is %u, expected %u\n", test->name,
+                            (unsigned) glyph.codepoint, (int) x, (int) y, actual, expected);
+                    test_failures++;
+                    return;
+                }
+            }
+        }
+
+        if ( !check_glyph(test, &glyph, &reference) ) {
+            return;
+        }
+    }
+}
+
+
+// blends every glyph of blit_ref in color onto gray8 and onto a surface of format whose rows start at odd
+// addresses, which must hold the same coverage blended channel by channel
+static void check_wide_format(font2c_format_t format, uint32_t size, uint32_t color, const uint32_t* maxima,
+                              const uint32_t* shifts, uint32_t n_channels) {
+    static uint8_t gray[MAX_SURFACE_HEIGHT * MAX_SURFACE_WIDTH];
+    static uint8_t wide[1 + (MAX_SURFACE_HEIGHT * ((MAX_SURFACE_WIDTH * 4) + 1))];
+    uint32_t i;
+
+    for (i = 0; i < blit_ref.n_glyphs; i++) {
+        font2c_surface_t surface;
+        font2c_glyph_t glyph;
+        int32_t width;
+        int32_t height;
+        uint32_t pitch;
+        int32_t x;
+        int32_t y;
+
+        font2c_glyph_at(&blit_ref, i, &glyph);
+        width = glyph.width + 3;
+        height = glyph.height + 2;
+        pitch = ((uint32_t) width * size) + 1;
+
+        memset(gray, 0, sizeof(gray));
+        font2c_surface_init(&surface, gray, FONT2C_FORMAT_GRAY8, (int16_t) width, (int16_t) height, (uint32_t) width);
+        font2c_blit_glyph(&surface, &blit_ref, &glyph, 1 - glyph.x_bearing, 1 + glyph.y_bearing, 0xFF);
+
+        memset(wide, 0, sizeof(wide));
+        font2c_surface_init(&surface, wide + 1, format, (int16_t) width, (int16_t) height, pitch);
+        font2c_blit_glyph(&surface, &blit_ref, &glyph, 1 - glyph.x_bearing, 1 + glyph.y_bearing, color);
+
+        for (y = 0; y < height; y++) {
+            for (x = 0; x < width; x++) {
+                const uint8_t* p = wide + 1 + ((uint32_t) y * pitch) + ((uint32_t) x * size);
+                uint32_t a = gray[(y * width) + x];
+                uint32_t expected = 0;
+                uint32_t actual;
+                uint32_t c;
+
+                for (c = 0; c < n_channels; c++) {
+                    expected |= font2c_mix(0, maxima[c], a) << shifts[c];
+                }
+
+                // rgb565 and argb8888 are native words, rgb888 is stored R, G, B
+                if ( format == FONT2C_FORMAT_RGB565 ) {
+                    uint16_t word;
+
+                    memcpy(&word, p, 2);
+                    actual = word;
+                } else if ( format == FONT2C_FORMAT_ARGB8888 ) {
+                    memcpy(&actual, p, 4);
+                } else {
+                    actual = ((uint32_t) p[0] << 16) | ((uint32_t) p[1] << 8) | p[2];
+                }
+
+                if ( actual != expected ) {
+                    fprintf(stderr, "format %d: U+%04X pixel (%d, %d) is 0x%08X, expected 0x%08X\n", (int) format,
+                            (unsigned) glyph.codepoint, (int) x, (int) y, (unsigned) actual, (unsigned) expected);
+                    test_failures++;
+                    return;
+                }
+            }
+        }
+    }
+}
+
+
+static void test_wide_formats(void) {
+    static const uint32_t rgb565_maxima[] = {0x1F, 0x2A, 0x10};
+    static const uint32_t rgb565_shifts[] = {11, 5, 0};
+    static const uint32_t rgb888_maxima[] = {0xFF, 0x80, 0x20};
+    static const uint32_t rgb888_shifts[] = {16, 8, 0};
+    static const uint32_t argb8888_maxima[] = {0xFF, 0xC0, 0x80, 0x40};
+    static const uint32_t argb8888_shifts[] = {24, 16, 8, 0};
+
+    check_wide_format(FONT2C_FORMAT_RGB565, 2, (0x1F << 11) | (0x2A << 5) | 0x10, rgb565_maxima, rgb565_shifts, 3);
+    check_wide_format(FONT2C_FORMAT_RGB888, 3, 0xFF8020, rgb888_maxima, rgb888_shifts, 3);
+    check_wide_format(FONT2C_FORMAT_ARGB8888, 4, 0xFFC08040, argb8888_maxima, argb8888_shifts, 4);
+}
+
+
+int main(void) {
+    size_t i;
+
+    for (i = 0; i < sizeof(blit_fonts) / sizeof(blit_fonts[0]); i++) {
+        check_font(&blit_fonts[i]);
+    }
+
+    test_wide_formats();
+
+    return test_failures ? 1 : 0;
+}
@@ -0,0 +1,164 @@
+/*
+ * font2c - Command-line utility for converting font glyphs into bitmap images
+ * embeddable in C source code.
+ *
+ * https://github.com/mattbucknall/font2c
+ *
+ * Copyright (C) 2022 Matthew T. Bucknall
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <string.h>
+
+#include "test.h"
+
+
+#define N_ENTRIES   3
+#define SLOT_SIZE   512
+#define WIDTH       200
+#define HEIGHT      24
+
+
+extern const font2c_font_t text_font;
+
+static font2c_cache_entry_t entries[N_ENTRIES];
+static uint8_t pool[N_ENTRIES * SLOT_SIZE];
+
+
+static const font2c_glyph_t* glyph_of(uint32_t codepoint) {
+    return font2c_find_glyph(&text_font, codepoint);
+}
+
+
+// returns the cached coverage of codepoint, checking that it matches the glyph decoded directly
+static const uint8_t* get(font2c_cache_t* cache, uint32_t codepoint) {
+    const font2c_glyph_t* glyph = glyph_of(codepoint);
+    const uint8_t* coverage = font2c_cache_get(cache, glyph);
+    font2c_bitmap_t bitmap;
+    uint8_t row[SLOT_SIZE];
+
+    CHECK(coverage != NULL);
+
+    if ( coverage ) {
+        font2c_bitmap_init(&bitmap, &text_font, glyph);
+
+        for (int32_t y = 0; y < glyph->height; y++) {
+            font2c_bitmap_row(&bitmap, 0, y, glyph->width, row);
+            CHECK(memcmp(coverage + (y * glyph->width), row, glyph->width) == 0);
+        }
+    }
+
+    return coverage;
+}
+
+
+static void check_entry(const font2c_cache_t* cache, uint32_t i, uint32_t codepoint, bool referenced) {
+    CHECK(cache->entries[i].valid);
+    CHECK_INT(cache->entries[i].codepoint, codepoint);
+    CHECK_INT(cache->entries[i].referenced, referenced);
+}
+
+
+static void test_clock(void) {
+    font2c_cache_t cache;
+
+    font2c_cache_init(&cache, &text_font, entries, N_ENTRIES, pool, SLOT_SIZE);
+
+    // empty entries are filled in order
+    get(&cache, 'A');
+    get(&cache, 'B');
+    get(&cache, 'C');
+    CHECK_INT(cache.misses, 3);
+    CHECK_INT(cache.hits, 0);
+    check_entry(&cache, 0, 'A', true);
+    check_entry(&cache, 1, 'B', true);
+    check_entry(&cache, 2, 'C', true);
+
+    CHECK(get(&cache, 'B') == entries[1].coverage);
+    CHECK_INT(cache.hits, 1);
+
+    // with every entry referenced, the hand clears each one on a full sweep and evicts where it started
+    get(&cache, 'D');
+    CHECK_INT(cache.misses, 4);
+    check_entry(&cache, 0, 'D', true);
+    check_entry(&cache, 1, 'B', false);
+    check_entry(&cache, 2, 'C', false);
+    CHECK_INT(cache.hand, 1);
+
+    // a referenced entry gets a second chance, so the next unreferenced one is evicted instead
+    get(&cache, 'B');
+    get(&cache, 'E');
+    check_entry(&cache, 0, 'D', true);
+    check_entry(&cache, 1, 'B', false);
+    check_entry(&cache, 2, 'E', true);
+    CHECK_INT(cache.hand, 0);
+
+    // the hand then clears D and evicts B, whose second chance has been used up
+    get(&cache, 'F');
+    check_entry(&cache, 0, 'D', false);
+    check_entry(&cache, 1, 'F', true);
+    check_entry(&cache, 2, 'E', true);
+    CHECK_INT(cache.hand, 2);
+
+    CHECK_INT(cache.hits, 2);
+    CHECK_INT(cache.misses, 6);
+}
+
+
+static void test_too_large(void) {
+    font2c_cache_t cache;
+
+    // glyphs larger than a slot are not cached and leave entries untouched
+    font2c_cache_init(&cache, &text_font, entries, N_ENTRIES, pool, 4);
+    CHECK(font2c_cache_get(&cache, glyph_of('W')) == NULL);
+    CHECK_INT(cache.misses, 1);
+    CHECK_INT(cache.hand, 0);
+    CHECK(!entries[0].valid);
+
+    // nor are any glyphs by a cache without entries
+    font2c_cache_init(&cache, &text_font, entries, 0, pool, SLOT_SIZE);
+    CHECK(font2c_cache_get(&cache, glyph_of('W')) == NULL);
+}
+
+
+static void test_matches_draw(void) {
+    static const char text[] = "ABABACDCDAEAEB";
+    static uint8_t expected[HEIGHT][WIDTH];
+    static uint8_t actual[HEIGHT][WIDTH];
+    font2c_surface_t surface;
+    font2c_cache_t cache;
+    int32_t y = text_font.ascent;
+
+    // a working set larger than the cache keeps evicting, and must draw exactly as the uncached path does
+    memset(expected, 0, sizeof(expected));
+    font2c_surface_init(&surface, expected, FONT2C_FORMAT_GRAY8, WIDTH, HEIGHT, WIDTH);
+    font2c_draw_utf8(&surface, &text_font, 2, y, text, strlen(text), 0xFF);
+
+    memset(actual, 0, sizeof(actual));
+    font2c_cache_init(&cache, &text_font, entries, N_ENTRIES, pool, SLOT_SIZE);
+    font2c_surface_init(&surface, actual, FONT2C_FORMAT_GRAY8, WIDTH, HEIGHT, WIDTH);
+    font2c_draw_utf8_cached(&surface, &cache, 2, y, text, strlen(text), 0xFF);
+
+    CHECK(memcmp(expected, actual, sizeof(expected)) == 0);
+    CHECK(cache.hits > 0);
+    CHECK(cache.misses > N_ENTRIES);
+    CHECK_INT(cache.hits + cache.misses, strlen(text));
+}
+
+
+int main(void) {
+    test_clock();
+    test_too_large();
+    test_matches_draw();
+
+    return test_failures ? 1 : 0;
+}
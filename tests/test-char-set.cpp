@@ -0,0 +1,131 @@
+/*
+ * font2c - Command-line utility for converting font glyphs into bitmap images
+ * embeddable in C source code.
+ *
+ * https://github.com/mattbucknall/font2c
+ *
+ * Copyright (C) 2022 Matthew T. Bucknall
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <set>
+
+#include "app-char-set.hpp"
+#include "test.h"
+
+
+// codepoints are drawn from a small span, so random ranges often overlap or touch
+static constexpr char32_t SPAN = 256;
+
+
+typedef std::set<char32_t> Reference;
+
+
+// ranges must stay sorted, disjoint and coalesced, and hold exactly the reference's codepoints
+static void check_equal(const app::CharSet& char_set, const Reference& reference) {
+    const auto& ranges = char_set.ranges();
+
+    for (size_t i = 0; i < ranges.size(); i++) {
+        CHECK(ranges[i].first <= ranges[i].last);
+        CHECK(i == 0 || ranges[i].first > ranges[i - 1].last + 1);
+    }
+
+    CHECK_INT(char_set.size(), reference.size());
+    CHECK(std::equal(char_set.begin(), char_set.end(), reference.begin(), reference.end()));
+
+    for (char32_t c = 0; c <= SPAN; c++) {
+        CHECK_INT(char_set.count(c), reference.count(c));
+    }
+}
+
+
+// random ranges inserted in random order, exercising the merge path as well as appends
+static void random_sets(std::mt19937& rng, app::CharSet& char_set, Reference& reference) {
+    std::uniform_int_distribution<int> n_ranges(0, 12);
+    std::uniform_int_distribution<char32_t> first(0, SPAN - 1);
+    std::uniform_int_distribution<char32_t> length(0, 12);
+
+    for (int n = n_ranges(rng); n > 0; n--) {
+        char32_t a = first(rng);
+        char32_t b = std::min(a + length(rng), SPAN - 1);
+
+        char_set.insert(a, b);
+
+        for (char32_t c = a; c <= b; c++) {
+            reference.insert(c);
+        }
+    }
+
+    check_equal(char_set, reference);
+}
+
+
+static void test_insert() {
+    std::mt19937 rng(1);
+
+    for (int i = 0; i < 2000; i++) {
+        app::CharSet char_set;
+        Reference reference;
+
+        random_sets(rng, char_set, reference);
+    }
+
+    // a range bridging two others, and ranges touching on either side, leave a single range
+    app::CharSet char_set;
+
+    char_set.insert(10, 19);
+    char_set.insert(30, 39);
+    char_set.insert(20, 29);
+    char_set.insert(40);
+    char_set.insert(9);
+    CHECK_INT(char_set.ranges().size(), 1);
+    CHECK_INT(char_set.size(), 32);
+}
+
+
+static void test_operations() {
+    std::mt19937 rng(2);
+
+    for (int i = 0; i < 2000; i++) {
+        app::CharSet a;
+        app::CharSet b;
+        Reference ra;
+        Reference rb;
+        Reference expected;
+
+        random_sets(rng, a, ra);
+        random_sets(rng, b, rb);
+
+        std::set_union(ra.begin(), ra.end(), rb.begin(), rb.end(), std::inserter(expected, expected.end()));
+        check_equal(app::char_set_union(a, b), expected);
+
+        expected.clear();
+        std::set_intersection(ra.begin(), ra.end(), rb.begin(), rb.end(), std::inserter(expected, expected.end()));
+        check_equal(app::char_set_intersection(a, b), expected);
+
+        expected.clear();
+        std::set_difference(ra.begin(), ra.end(), rb.begin(), rb.end(), std::inserter(expected, expected.end()));
+        check_equal(app::char_set_difference(a, b), expected);
+    }
+}
+
+
+int main() {
+    test_insert();
+    test_operations();
+
+    return test_failures ? 1 : 0;
+}
@@ -0,0 +1,90 @@
+/*
+ * font2c - Command-line utility for converting font glyphs into bitmap images
+ * embeddable in C source code.
+ *
+ * https://github.com/mattbucknall/font2c
+ *
+ * Copyright (C) 2022 Matthew T. Bucknall
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <string>
+
+#include "app-char-set.hpp"
+#include "app-corpus.hpp"
+#include "test.h"
+
+
+static std::string scanned(const char* name) {
+    app::CharSet char_set;
+    std::string text;
+
+    app::corpus_scan(std::string(FONT2C_TEST_DATA "/corpus/") + name, char_set);
+
+    for (auto c: char_set) {
+        text += static_cast<char>(c);
+    }
+
+    return text;
+}
+
+
+// preprocessor directives other than #define and the "C" of extern "C" are not displayed text, hex escapes take
+// every hex digit that follows, and quotes after encoding prefixes start character literals, not digit separators
+static void test_source() {
+    CHECK(scanned("source.c") == "AHOZeiksy");
+}
+
+
+// neither is msgctxt, nor the metadata held by the header entry's msgstr
+static void test_po() {
+    CHECK(scanned("messages.po") == "abcdefghij");
+}
+
+
+static bool add_ranges(std::string_view ranges, app::CharSet& char_set) {
+    try {
+        app::char_set_add_ranges(char_set, ranges);
+        return true;
+    } catch (app::Error&) {
+        return false;
+    }
+}
+
+
+// --include accepts codepoints and ranges written as in .hex character sets
+static void test_ranges() {
+    app::CharSet char_set;
+
+    CHECK(add_ranges("30-39,U+41..U+43, 0x61 - 0x62,B0", char_set));
+    CHECK_INT(char_set.size(), 16);
+    CHECK_INT(char_set.count(0x39), 1);
+    CHECK_INT(char_set.count(0x43), 1);
+    CHECK_INT(char_set.count(0x62), 1);
+    CHECK_INT(char_set.count(0xB0), 1);
+
+    CHECK(!add_ranges("7E-20", char_set));
+    CHECK(!add_ranges("20-", char_set));
+    CHECK(!add_ranges("20,,21", char_set));
+    CHECK(!add_ranges("G", char_set));
+    CHECK(!add_ranges("110000", char_set));
+}
+
+
+int main() {
+    test_source();
+    test_po();
+    test_ranges();
+
+    return test_failures ? 1 : 0;
+}
@@ -0,0 +1,98 @@
+/*
+ * font2c - Command-line utility for converting font glyphs into bitmap images
+ * embeddable in C source code.
+ *
+ * https://github.com/mattbucknall/font2c
+ *
+ * Copyright (C) 2022 Matthew T. Bucknall
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <algorithm>
+#include <vector>
+
+#include "app-font.hpp"
+#include "test.h"
+
+
+extern "C" const font2c_font_t text_font_kerned;
+
+
+// text_font_kerned is FONT2C_TEST_FONT at 16 pixels with kerning, so every lookup must give FreeType's value for the
+// same pair of glyphs, and glyphs missing from the table must not kern at all
+static void test_lookup(app::Font& font) {
+    const font2c_font_t* kerned = &text_font_kerned;
+    auto pairs = font.kerning_pairs();
+    std::vector<unsigned int> indices;
+    size_t n_kerned = 0;
+
+    CHECK(font.has_kerning());
+    CHECK(pairs.has_value());
+    CHECK(kerned->n_kerning > 0);
+
+    for (uint32_t i = 0; i < kerned->n_glyphs; i++) {
+        font2c_glyph_t glyph;
+
+        font2c_glyph_at(kerned, i, &glyph);
+        indices.push_back(font.char_index(glyph.codepoint));
+    }
+
+    for (uint32_t l = 0; l < kerned->n_glyphs; l++) {
+        font2c_glyph_t left;
+
+        font2c_glyph_at(kerned, l, &left);
+
+        for (uint32_t r = 0; r < kerned->n_glyphs; r++) {
+            int expected = font.kerning(indices[l], indices[r]);
+            font2c_glyph_t right;
+
+            font2c_glyph_at(kerned, r, &right);
+            CHECK_INT(font2c_kerning(kerned, (int32_t) l, (int32_t) r), expected);
+
+            if ( expected == 0 ) {
+                continue;
+            }
+
+            n_kerned++;
+
+            // every kerned pair is listed in the font's pair table, which the generator reads instead of probing
+            CHECK(pairs && std::binary_search(pairs->begin(), pairs->end(), std::make_pair(indices[l], indices[r])));
+
+            // and the lookup's users apply it between the two glyphs
+            uint32_t codepoints[2] = {left.codepoint, right.codepoint};
+            char text[3] = {static_cast<char>(left.codepoint), static_cast<char>(right.codepoint), '\0'};
+            font2c_iter_t iter;
+
+            CHECK_INT(font2c_text_width(kerned, codepoints, 2), left.x_advance + expected + right.x_advance);
+
+            font2c_iter_init(&iter, kerned, text, 2);
+            CHECK(font2c_iter_next(&iter) && font2c_iter_next(&iter));
+            CHECK_INT(iter.x, left.x_advance + expected);
+        }
+    }
+
+    CHECK_INT(n_kerned, kerned->n_kerning);
+
+    // indices outside the font, or no glyph at all, never kern
+    CHECK_INT(font2c_kerning(kerned, -1, 0), 0);
+    CHECK_INT(font2c_kerning(kerned, 0, (int32_t) kerned->n_glyphs), 0);
+}
+
+
+int main() {
+    app::Font font(FONT2C_TEST_FONT_PATH, 16);
+
+    test_lookup(font);
+
+    return test_failures ? 1 : 0;
+}
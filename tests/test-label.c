@@ -0,0 +1,153 @@
+/*
+ * font2c - Command-line utility for converting font glyphs into bitmap images
+ * embeddable in C source code.
+ *
+ * https://github.com/mattbucknall/font2c
+ *
+ * Copyright (C) 2022 Matthew T. Bucknall
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <string.h>
+
+#include "test.h"
+
+
+#define LABEL_X     10
+#define WIDTH       200
+#define HEIGHT      32
+
+
+extern const font2c_font_t text_font;
+
+static font2c_cell_t cells[16];
+static uint8_t pixels[HEIGHT][WIDTH];
+static uint8_t expected[HEIGHT][WIDTH];
+
+
+// extent of the cell holding text[n] (text_font has no kerning): the union of its advance and its ink
+static void cell_extent(const char* text, size_t n, int32_t* x1, int32_t* x2) {
+    int32_t x = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        x += font2c_find_glyph(&text_font, (uint8_t) text[i])->x_advance;
+    }
+
+    const font2c_glyph_t* glyph = font2c_find_glyph(&text_font, (uint8_t) text[n]);
+
+    *x1 = x;
+    *x2 = x + glyph->x_advance;
+
+    if ( glyph->width ) {
+        if ( (x + glyph->x_bearing) < *x1 ) *x1 = x + glyph->x_bearing;
+        if ( (x + glyph->x_bearing + glyph->width) > *x2 ) *x2 = x + glyph->x_bearing + glyph->width;
+    }
+}
+
+
+static void check_rect(const font2c_label_t* label, const font2c_rect_t* rect, int32_t x1, int32_t x2) {
+    CHECK_INT(rect->x, label->x + x1);
+    CHECK_INT(rect->width, x2 - x1);
+    CHECK_INT(rect->y, label->y - text_font.ascent);
+    CHECK_INT(rect->height, text_font.ascent + text_font.descent);
+}
+
+
+// changes the label from text to next, checking that exactly cell n (of either text, or both) is dirty and that
+// redrawing only the dirty area leaves the same pixels as drawing next from scratch
+static void check_update(font2c_label_t* label, font2c_surface_t* surface, const char* text, const char* next,
+                         size_t n) {
+    font2c_surface_t fresh;
+    font2c_rect_t dirty[4];
+    size_t n_dirty;
+    int32_t x1 = 0;
+    int32_t x2 = 0;
+
+    font2c_label_update(label, text, strlen(text), dirty, 4);
+    memset(pixels, 0, sizeof(pixels));
+    font2c_draw_utf8(surface, &text_font, label->x, label->y, text, strlen(text), 0xFF);
+
+    n_dirty = font2c_label_update(label, next, strlen(next), dirty, 4);
+    CHECK_INT(n_dirty, 1);
+
+    if ( n < strlen(text) && n < strlen(next) ) {
+        int32_t next_x1;
+        int32_t next_x2;
+
+        cell_extent(text, n, &x1, &x2);
+        cell_extent(next, n, &next_x1, &next_x2);
+
+        if ( next_x1 < x1 ) x1 = next_x1;
+        if ( next_x2 > x2 ) x2 = next_x2;
+    } else {
+        cell_extent((n < strlen(text)) ? text : next, n, &x1, &x2);
+    }
+
+    if ( n_dirty == 1 ) {
+        check_rect(label, &dirty[0], x1, x2);
+    }
+
+    font2c_label_draw(label, surface, dirty, n_dirty, 0xFF, 0);
+
+    memset(expected, 0, sizeof(expected));
+    font2c_surface_init(&fresh, expected, FONT2C_FORMAT_GRAY8, WIDTH, HEIGHT, WIDTH);
+    font2c_draw_utf8(&fresh, &text_font, label->x, label->y, next, strlen(next), 0xFF);
+
+    CHECK(memcmp(pixels, expected, sizeof(pixels)) == 0);
+}
+
+
+static void test_dirty_cells(void) {
+    font2c_surface_t surface;
+    font2c_label_t label;
+    font2c_rect_t dirty[4];
+    int32_t x1;
+    int32_t x2;
+    int32_t next_x1;
+    int32_t next_x2;
+
+    font2c_surface_init(&surface, pixels, FONT2C_FORMAT_GRAY8, WIDTH, HEIGHT, WIDTH);
+    font2c_label_init(&label, &text_font, LABEL_X, text_font.ascent, cells, 16);
+
+    // digits share one advance, so changing one leaves every other cell where it was
+    check_update(&label, &surface, "12:34", "12:35", 4);
+    check_update(&label, &surface, "12:34", "12:94", 3);
+    check_update(&label, &surface, "12:34", "92:34", 0);
+
+    // a narrower glyph replacing a wider one dirties the old glyph's extent too, and the reverse
+    check_update(&label, &surface, "12:W", "12:i", 3);
+    check_update(&label, &surface, "12:i", "12:W", 3);
+
+    // shorter and longer text dirty only the cell removed or added
+    check_update(&label, &surface, "12:34", "12:3", 4);
+    check_update(&label, &surface, "12:3", "12:34", 4);
+
+    // unchanged text needs no redraw
+    CHECK_INT(font2c_label_update(&label, "12:34", 5, dirty, 4), 0);
+
+    // changes apart from one another are reported separately, but merged once rectangles run out
+    CHECK_INT(font2c_label_update(&label, "92:35", 5, dirty, 4), 2);
+    CHECK_INT(font2c_label_update(&label, "12:34", 5, dirty, 1), 1);
+    cell_extent("12:34", 0, &x1, &x2);
+    cell_extent("92:35", 0, &next_x1, &next_x2);
+    CHECK_INT(dirty[0].x, LABEL_X + ((x1 < next_x1) ? x1 : next_x1));
+    cell_extent("12:34", 4, &x1, &x2);
+    cell_extent("92:35", 4, &next_x1, &next_x2);
+    CHECK_INT(dirty[0].x + dirty[0].width, LABEL_X + ((x2 > next_x2) ? x2 : next_x2));
+}
+
+
+int main(void) {
+    test_dirty_cells();
+
+    return test_failures ? 1 : 0;
+}
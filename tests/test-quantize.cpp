@@ -0,0 +1,56 @@
+/*
+ * font2c - Command-line utility for converting font glyphs into bitmap images
+ * embeddable in C source code.
+ *
+ * https://github.com/mattbucknall/font2c
+ *
+ * Copyright (C) 2022 Matthew T. Bucknall
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "app-quantize.hpp"
+#include "test.h"
+
+
+// evenly spaced levels must be the values font2c_expand() gives each pixel value at runtime
+static void test_levels_match_runtime() {
+    for (int depth = 1; depth <= 8; depth++) {
+        std::vector<uint8_t> levels = app::quantize_levels(depth);
+
+        CHECK_INT(levels.size(), 1u << depth);
+
+        for (uint32_t value = 0; value < levels.size(); value++) {
+            CHECK_INT(levels[value], font2c_expand(value, static_cast<uint8_t>(depth)));
+        }
+    }
+}
+
+
+// blank and solid coverage must survive quantization at every depth
+static void test_table_end_points() {
+    for (int depth = 1; depth <= 8; depth++) {
+        std::vector<uint8_t> levels = app::quantize_levels(depth);
+        app::QuantizeTable table = app::quantize_table(levels);
+
+        CHECK_INT(levels[table[0]], 0);
+        CHECK_INT(levels[table[255]], 255);
+    }
+}
+
+
+int main() {
+    test_levels_match_runtime();
+    test_table_end_points();
+
+    return test_failures ? 1 : 0;
+}
@@ -0,0 +1,247 @@
+/*
+ * font2c - Command-line utility for converting font glyphs into bitmap images
+ * embeddable in C source code.
+ *
+ * https://github.com/mattbucknall/font2c
+ *
+ * Copyright (C) 2022 Matthew T. Bucknall
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "test.h"
+
+
+#define MAX_READS   16
+#define WIDTH       200
+#define HEIGHT      24
+
+
+extern const font2c_font_t text_font;
+extern const font2c_font_t external_font;
+
+
+// read callback backed by memory, logging every transaction
+typedef struct {
+    const uint8_t* data;
+    uint32_t size;
+    uint32_t n_reads;
+    uint32_t offsets[MAX_READS];
+    uint32_t lengths[MAX_READS];
+    bool fail;
+} memory_t;
+
+
+static bool memory_read(void* context, uint32_t offset, void* buffer, uint32_t length) {
+    memory_t* memory = (memory_t*) context;
+
+    if ( memory->fail || offset > memory->size || length > (memory->size - offset) ) {
+        return false;
+    }
+
+    if ( memory->n_reads < MAX_READS ) {
+        memory->offsets[memory->n_reads] = offset;
+        memory->lengths[memory->n_reads] = length;
+    }
+
+    memory->n_reads++;
+    memcpy(buffer, memory->data + offset, length);
+
+    return true;
+}
+
+
+// reads must be ascending, disjoint and further apart than max_gap, and fill the buffer back to back
+static void check_reads(const memory_t* memory, const font2c_run_t* run, uint32_t max_gap) {
+    uint32_t total = 0;
+
+    CHECK_INT(memory->n_reads, run->n_reads);
+
+    for (uint32_t i = 0; i < memory->n_reads && i < MAX_READS; i++) {
+        if ( i > 0 ) {
+            uint32_t prev_end = memory->offsets[i - 1] + memory->lengths[i - 1];
+
+            CHECK(memory->offsets[i] > prev_end && (memory->offsets[i] - prev_end) > max_gap);
+        }
+
+        total += memory->lengths[i];
+    }
+
+    CHECK_INT(total, run->size);
+}
+
+
+// every glyph's bytes in the run buffer must be those at its original offset
+static void check_glyphs(const font2c_run_t* run, const uint8_t* buffer, const uint8_t* data,
+                         const uint32_t* original, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        const font2c_glyph_t* glyph = &run->glyphs[i].glyph;
+        uint32_t size = font2c_glyph_size(&run->font, glyph);
+
+        // glyphs are sorted by fetch, so their original offset is found by their position
+        size_t k = (size_t) run->glyphs[i].x;
+
+        CHECK(glyph->offset + size <= run->size);
+        CHECK(memcmp(buffer + glyph->offset, data + original[k], size) == 0);
+    }
+}
+
+
+static void test_batching(void) {
+    const font2c_glyph_t* w = font2c_find_glyph(&external_font, 'W');
+    uint32_t size = font2c_glyph_size(&external_font, w);
+    static uint8_t data[4096];
+    static uint8_t buffer[4096];
+    font2c_run_glyph_t glyphs[6];
+    font2c_run_t run;
+    memory_t memory;
+
+    // out of order, duplicated, overlapping, within and beyond max_gap of one another, and far apart
+    const uint32_t original[6] = {1000, 200, 1000 + (size / 2), 200, 1000 + size + (size / 2) + 8, 3000};
+
+    CHECK(size > 16 && 200 + size + 8 < 1000 && 3000 + size <= sizeof(data));
+
+    for (uint32_t i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t) ((i * 31) + (i >> 8));
+    }
+
+    for (uint32_t gap = 7; gap <= 8; gap++) {
+        memset(&run, 0, sizeof(run));
+        run.font = external_font;
+        run.glyphs = glyphs;
+        run.n_glyphs = 6;
+
+        // each glyph's x records its position in original[], which fetch's sort does not preserve
+        for (size_t i = 0; i < 6; i++) {
+            glyphs[i].glyph = *w;
+            glyphs[i].glyph.offset = original[i];
+            glyphs[i].x = (int32_t) i;
+            glyphs[i].y = 0;
+        }
+
+        memset(&memory, 0, sizeof(memory));
+        memory.data = data;
+        memory.size = sizeof(data);
+
+        CHECK(font2c_run_fetch(&run, memory_read, &memory, buffer, sizeof(buffer), gap));
+        CHECK_INT(run.n_reads, (gap == 8) ? 3 : 4);
+        CHECK_INT(memory.offsets[0], 200);
+        CHECK_INT(memory.lengths[0], size);
+        CHECK_INT(memory.offsets[1], 1000);
+        CHECK(run.font.pixels == buffer);
+        CHECK(!(run.font.flags & FONT2C_FLAG_EXTERNAL));
+
+        for (size_t i = 1; i < 6; i++) {
+            CHECK(glyphs[i - 1].glyph.offset <= glyphs[i].glyph.offset);
+        }
+
+        check_reads(&memory, &run, gap);
+        check_glyphs(&run, buffer, data, original, 6);
+    }
+}
+
+
+static void test_fetch_errors(void) {
+    static uint8_t data[4096];
+    static uint8_t buffer[4096];
+    font2c_run_glyph_t glyphs[8];
+    font2c_run_t run;
+    memory_t memory;
+
+    memset(&memory, 0, sizeof(memory));
+    memory.data = data;
+    memory.size = sizeof(data);
+
+    // too small a buffer fails before reading
+    font2c_run_init(&run, &external_font, "AW", 2, glyphs, 8);
+    CHECK(!font2c_run_fetch(&run, memory_read, &memory, buffer, 8, 0));
+    CHECK_INT(memory.n_reads, 0);
+
+    font2c_run_init(&run, &external_font, "AW", 2, glyphs, 8);
+    memory.fail = true;
+    CHECK(!font2c_run_fetch(&run, memory_read, &memory, buffer, sizeof(buffer), 0));
+}
+
+
+static uint8_t* load(const char* path, uint32_t* size) {
+    FILE* f = fopen(path, "rb");
+    uint8_t* data = NULL;
+    long length;
+
+    if ( !f ) {
+        return NULL;
+    }
+
+    if ( fseek(f, 0, SEEK_END) == 0 && (length = ftell(f)) > 0 && fseek(f, 0, SEEK_SET) == 0 ) {
+        data = (uint8_t*) malloc((size_t) length);
+
+        if ( data && fread(data, 1, (size_t) length, f) != (size_t) length ) {
+            free(data);
+            data = NULL;
+        }
+
+        *size = (uint32_t) length;
+    }
+
+    fclose(f);
+
+    return data;
+}
+
+
+static void test_matches_draw(void) {
+    static const char text[] = "Run AVAVA fetch";
+    static uint8_t expected[HEIGHT][WIDTH];
+    static uint8_t actual[HEIGHT][WIDTH];
+    static uint8_t buffer[8192];
+    font2c_run_glyph_t glyphs[32];
+    font2c_surface_t surface;
+    font2c_run_t run;
+    memory_t memory;
+    int32_t y = text_font.ascent;
+
+    memset(&memory, 0, sizeof(memory));
+    memory.data = load(FONT2C_TEST_FONT_DIR "/external_font.bin", &memory.size);
+    CHECK(memory.data != NULL);
+
+    if ( !memory.data ) {
+        return;
+    }
+
+    // external_font is text_font with its pixel data moved out, so a fetched run draws the same pixels
+    memset(expected, 0, sizeof(expected));
+    font2c_surface_init(&surface, expected, FONT2C_FORMAT_GRAY8, WIDTH, HEIGHT, WIDTH);
+    font2c_draw_utf8(&surface, &text_font, 2, y, text, strlen(text), 0xFF);
+
+    CHECK_INT(font2c_run_init(&run, &external_font, text, strlen(text), glyphs, 32), strlen(text));
+    CHECK(font2c_run_fetch(&run, memory_read, &memory, buffer, sizeof(buffer), 16));
+    check_reads(&memory, &run, 16);
+
+    memset(actual, 0, sizeof(actual));
+    font2c_surface_init(&surface, actual, FONT2C_FORMAT_GRAY8, WIDTH, HEIGHT, WIDTH);
+    font2c_run_draw(&surface, &run, 2, y, 0xFF);
+
+    CHECK(memcmp(expected, actual, sizeof(expected)) == 0);
+
+    free((void*) memory.data);
+}
+
+
+int main(void) {
+    test_batching();
+    test_fetch_errors();
+    test_matches_draw();
+
+    return test_failures ? 1 : 0;
+}
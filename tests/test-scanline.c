@@ -0,0 +1,101 @@
+/*
+ * font2c - Command-line utility for converting font glyphs into bitmap images
+ * embeddable in C source code.
+ *
+ * https://github.com/mattbucknall/font2c
+ *
+ * Copyright (C) 2022 Matthew T. Bucknall
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <string.h>
+
+#include "test.h"
+
+
+#define WIDTH   320
+#define HEIGHT  24
+
+
+extern const font2c_font_t text_font;
+extern const font2c_font_t external_font;
+
+static const char TEXT[] = "Scanline AVA";
+
+static uint8_t pixels[HEIGHT][WIDTH];
+
+
+static void test_matches_blit(void) {
+    font2c_span_t spans[16];
+    font2c_scanline_t scanline;
+    font2c_surface_t surface;
+    uint8_t coverage[WIDTH];
+    int32_t y = text_font.ascent;
+
+    memset(pixels, 0, sizeof(pixels));
+    font2c_surface_init(&surface, pixels, FONT2C_FORMAT_GRAY8, WIDTH, HEIGHT, WIDTH);
+    font2c_draw_utf8(&surface, &text_font, 3, y, TEXT, strlen(TEXT), 0xFF);
+
+    CHECK(font2c_scanline_init(&scanline, &text_font, 3, y, TEXT, strlen(TEXT), spans, 16));
+    CHECK(scanline.y >= 0 && scanline.y_end <= HEIGHT);
+
+    while (scanline.y < scanline.y_end) {
+        int32_t row = scanline.y;
+
+        CHECK(font2c_scanline_render(&scanline, coverage, WIDTH));
+        CHECK(memcmp(coverage, pixels[row], WIDTH) == 0);
+    }
+
+    CHECK(!font2c_scanline_render(&scanline, coverage, WIDTH));
+}
+
+
+static void test_too_many_glyphs(void) {
+    font2c_span_t spans[16];
+    font2c_scanline_t scanline;
+    uint8_t coverage[WIDTH];
+
+    // the space has no ink and needs no span, every other glyph does
+    CHECK(font2c_scanline_init(&scanline, &text_font, 0, 16, TEXT, strlen(TEXT), spans, strlen(TEXT) - 1));
+    CHECK(!font2c_scanline_init(&scanline, &text_font, 0, 16, TEXT, strlen(TEXT), spans, strlen(TEXT) - 2));
+    CHECK_INT(scanline.n_spans, 0);
+    CHECK(!font2c_scanline_render(&scanline, coverage, WIDTH));
+}
+
+
+static void test_unsupported_fonts(void) {
+    font2c_span_t spans[16];
+    font2c_scanline_t scanline;
+    font2c_font_t rotated = text_font;
+    font2c_font_t chained = text_font;
+
+    CHECK(!font2c_scanline_init(&scanline, &external_font, 0, 16, TEXT, strlen(TEXT), spans, 16));
+
+    rotated.raster = FONT2C_RASTER_RLTB;
+    CHECK(font2c_scanline_init(&scanline, &rotated, 0, 16, TEXT, strlen(TEXT), spans, 16));
+
+    // fallback laid out differently from font it backs
+    chained.fallback = &rotated;
+    CHECK(!font2c_scanline_init(&scanline, &chained, 0, 16, TEXT, strlen(TEXT), spans, 16));
+
+    chained.fallback = &external_font;
+    CHECK(!font2c_scanline_init(&scanline, &chained, 0, 16, TEXT, strlen(TEXT), spans, 16));
+}
+
+
+int main(void) {
+    test_matches_blit();
+    test_too_many_glyphs();
+    test_unsupported_fonts();
+
+    return test_failures ? 1 : 0;
+}
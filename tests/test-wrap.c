@@ -0,0 +1,164 @@
+/*
+ * font2c - Command-line utility for converting font glyphs into bitmap images
+ * embeddable in C source code.
+ *
+ * https://github.com/mattbucknall/font2c
+ *
+ * Copyright (C) 2022 Matthew T. Bucknall
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <string.h>
+
+#include "test.h"
+
+
+extern const font2c_font_t text_font;
+extern const font2c_font_t text_font_kerned;
+
+
+static uint32_t lines_of(const font2c_font_t* font, const char* text) {
+    font2c_metrics_t metrics;
+
+    font2c_measure_utf8(font, text, strlen(text), &metrics);
+
+    return metrics.n_lines;
+}
+
+
+static int32_t width_of(const font2c_font_t* font, const char* text) {
+    font2c_metrics_t metrics;
+
+    font2c_measure_utf8(font, text, strlen(text), &metrics);
+
+    return metrics.width;
+}
+
+
+static void check_lines(const font2c_font_t* font, const char* text, int32_t max_width,
+                        const char* const* expected, size_t n_expected) {
+    font2c_line_t lines[16];
+    size_t n_lines = font2c_wrap_utf8(font, text, strlen(text), max_width, lines, 16);
+
+    CHECK_INT(n_lines, n_expected);
+
+    for (size_t i = 0; i < n_lines && i < n_expected; i++) {
+        size_t length = strlen(expected[i]);
+
+        CHECK_INT(lines[i].length, length);
+
+        if ( lines[i].length == length && memcmp(text + lines[i].start, expected[i], length) != 0 ) {
+            fprintf(stderr, "line %zu of '%s' is '%.*s', expected '%s'\n", i, text, (int) lines[i].length,
+                    text + lines[i].start, expected[i]);
+            test_failures++;
+        }
+
+        CHECK_INT(lines[i].width, width_of(font, expected[i]));
+    }
+}
+
+
+static void test_long_words(void) {
+    const char* const split[] = {"aaa", "aaa", "aaa", "a"};
+    const char* const single[] = {"a", "a", "a"};
+    const char* const carried[] = {"a", "bbb", "bbb", "bb"};
+
+    // words wider than the line are broken before the first character that overflows
+    check_lines(&text_font, "aaaaaaaaaa", width_of(&text_font, "aaa"), split, 4);
+
+    // every line holds at least one character, even if it is wider than the line
+    check_lines(&text_font, "aaa", 1, single, 3);
+
+    // a long word after a space moves to its own line before being broken
+    check_lines(&text_font, "a bbbbbbbb", width_of(&text_font, "bbb"), carried, 4);
+}
+
+
+static void test_newlines(void) {
+    const char* const two[] = {"ab", "cd"};
+    const char* const blank[] = {"ab", "", "cd"};
+    const char* const one[] = {"abc"};
+    const char* const trailing[] = {"ab", ""};
+    const char* const rewrapped[] = {"ab", "cd", "ef"};
+
+    check_lines(&text_font, "ab\ncd", 1000, two, 2);
+    check_lines(&text_font, "ab\n\ncd", 1000, blank, 3);
+
+    // a final line break ends the last line, only a second one adds an empty line
+    check_lines(&text_font, "abc\n", 1000, one, 1);
+    check_lines(&text_font, "ab\n\n", 1000, trailing, 2);
+    check_lines(&text_font, "\n", 1000, trailing + 1, 1);
+
+    // measuring counts the same lines as wrapping text too wide to need it
+    CHECK_INT(lines_of(&text_font, "ab\ncd"), 2);
+    CHECK_INT(lines_of(&text_font, "ab\n\ncd"), 3);
+    CHECK_INT(lines_of(&text_font, "abc\n"), 1);
+    CHECK_INT(lines_of(&text_font, "ab\n\n"), 2);
+    CHECK_INT(lines_of(&text_font, "\n"), 1);
+    CHECK_INT(lines_of(&text_font, ""), 0);
+
+    // a newline also ends a line that was wrapped, and resets the wrap position
+    check_lines(&text_font, "ab cd\nef", width_of(&text_font, "ab c"), rewrapped, 3);
+}
+
+
+static void test_trailing_spaces(void) {
+    const char* const one[] = {"ab"};
+    const char* const two[] = {"ab", "cd"};
+    const char* const wrapped[] = {"aa", "bb"};
+
+    // spaces ending a line are excluded from its length and width
+    check_lines(&text_font, "ab   ", 1000, one, 1);
+    check_lines(&text_font, "ab   \ncd", 1000, two, 2);
+
+    // the space run a line is broken at belongs to neither line
+    check_lines(&text_font, "aa   bb", width_of(&text_font, "aa b"), wrapped, 2);
+}
+
+
+static void test_line_limit(void) {
+    font2c_line_t lines[1];
+
+    // lines beyond max_lines are counted but not stored
+    CHECK_INT(font2c_wrap_utf8(&text_font, "a\nb\nc", 5, 1000, lines, 1), 3);
+    CHECK_INT(lines[0].start, 0);
+    CHECK_INT(lines[0].length, 1);
+    CHECK_INT(font2c_wrap_utf8(&text_font, "", 0, 1000, lines, 1), 0);
+}
+
+
+static void test_kerned_widths(void) {
+    static const char text[] = "AVAVAV To Wa AVAVAVAVAV yT LT";
+    font2c_line_t lines[16];
+    size_t n_lines = font2c_wrap_utf8(&text_font_kerned, text, strlen(text), 60, lines, 16);
+
+    // each line is as wide as the same text measured on its own
+    for (size_t i = 0; i < n_lines; i++) {
+        char line[sizeof(text)];
+
+        memcpy(line, text + lines[i].start, lines[i].length);
+        line[lines[i].length] = '\0';
+        CHECK(lines[i].width <= 60 || lines[i].length == 1);
+        CHECK_INT(lines[i].width, width_of(&text_font_kerned, line));
+    }
+}
+
+
+int main(void) {
+    test_long_words();
+    test_newlines();
+    test_trailing_spaces();
+    test_line_limit();
+    test_kerned_widths();
+
+    return test_failures ? 1 : 0;
+}